@@ -0,0 +1,47 @@
+/*
+ * host build of the benchmarks in util.c
+ *
+ * usage:
+ *      gcc -O2 -DUTIL_BENCHMARK -Iinclude bench/host.c util.c -lm -o utilBench && ./utilBench [scratch file]
+ *
+ *      the timer is CLOCK_MONOTONIC, so all results are in ns. Allocations use malloc() and free() instead of the static arena,
+ *      that one is only a few kB and would make the larger tables and configs fail
+ *
+ *      NOTE: CONFIG_benchmark() only runs if ff.h is found, that needs a FatFs port for the host (f.e. on a disk image).
+ *            The scratch file (bench.cfg by default) is overwritten
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util.h"
+
+int main(int argc, char ** argv){
+    UTIL_setAllocator(malloc, free);
+    
+    UTIL_benchmark(printf);
+    
+#if __has_include("ff.h")
+    const char * path = (argc > 1) ? argv[1] : "bench.cfg";
+    
+    FATFS fs;
+    FIL scratch;
+    if(f_mount(&fs, "", 1) != FR_OK){
+        printf("mounting the FatFs volume failed, skipping CONFIG_benchmark()\r\n");
+        return 1;
+    }
+    if(f_open(&scratch, path, FA_READ | FA_WRITE | FA_CREATE_ALWAYS) != FR_OK){
+        printf("can't open \"%s\", skipping CONFIG_benchmark()\r\n", path);
+        return 1;
+    }
+    
+    CONFIG_benchmark(&scratch, printf);
+    
+    f_close(&scratch);
+#else
+    (void) argc;
+    (void) argv;
+#endif
+    
+    return 0;
+}
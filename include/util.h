@@ -2,41 +2,410 @@
 #define UTIL_INC
     
 #include <stdint.h>
+#include <stddef.h>
 
-#define CONFIG_MAX_LINE_SIZE 128
-#define CONFIG_MAX_LINE_COUNT 128
+//size of the static arena util.c allocates from if there is no FreeRTOS and no other allocator was set (see UTIL_setAllocator()). 0 makes it allocation free
+#ifndef UTIL_ARENA_SIZE
+#define UTIL_ARENA_SIZE 4096
+#endif
+
+typedef void * (* UTIL_mallocFunction_t)(size_t size);
+typedef void (* UTIL_freeFunction_t)(void * ptr);
+
+void UTIL_setAllocator(UTIL_mallocFunction_t mallocFunction, UTIL_freeFunction_t freeFunction);
+void * UTIL_arenaMalloc(size_t size);
+void UTIL_arenaFree(void * ptr);
+size_t UTIL_getAllocatedBytes(void);
+
+//allocate and free with whatever allocator util.c uses, values returned by CONFIG_getKey() and CONFIG_getKeys() must be freed with UTIL_free()
+void * UTIL_malloc(size_t size);
+void UTIL_free(void * ptr);
+
+//time base for benchmarks, cycles on a Cortex-M3 and up and nanoseconds on a host
+void UTIL_initCycleCounter(void);
+uint32_t UTIL_getCycles(void);
+
+//the config tools read files in blocks of this size (the sector size of the SD card), the buffer of CONFIG_getKey() and CONFIG_load() is CONFIG_BUFFER_SIZE
+#define CONFIG_BLOCK_SIZE 512
+#define CONFIG_BUFFER_SIZE (2 * CONFIG_BLOCK_SIZE)
+
+//number of points per segment that NTC_generateAdaptivePWL() checks when looking for the largest error
+#define NTC_ADAPTIVE_SAMPLES 32
+
+//flags of a ConfigEntry_t
+#define CONFIG_ENTRY_NUMBER 1       //the value is a number, mantissa and exponent hold it already parsed
+#define CONFIG_ENTRY_TRUNCATED 2    //the number had more digits than the mantissa can hold
+
+//one key/value pair of a Config_t, the offsets are from the start of the strings of the index
+typedef struct{
+    uint32_t hash;
+    uint32_t keyOffset;
+    uint32_t valueOffset;
+    int32_t mantissa;       //value = mantissa * 10^exponent, only valid if CONFIG_ENTRY_NUMBER is set
+    int16_t exponent;
+    uint16_t flags;
+} ConfigEntry_t;
+
+//index of a whole config file, created by CONFIG_load(). The entries are sorted by hash and followed by the strings
+typedef struct{
+    uint32_t entryCount;
+    uint32_t stringSize;
+    uint32_t sourceSize;        //size, timestamp and crc32 of the file the index was created from, used by CONFIG_hasChanged() and the cache
+    uint32_t sourceTimestamp;
+    uint32_t sourceCrc;
+    ConfigEntry_t entries[];
+} Config_t;
+
+//size of a whole config index including all strings
+#define CONFIG_getSize(CFG) (sizeof(Config_t) + (CFG)->entryCount * sizeof(ConfigEntry_t) + (CFG)->stringSize)
+
+//header of a cache file written by CONFIG_loadCached(), the config index follows it unchanged
+#define CONFIG_CACHE_MAGIC 0x47464355   //"UCFG"
+#define CONFIG_CACHE_VERSION 1
+
+typedef struct{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sourceSize;
+    uint32_t sourceTimestamp;
+    uint32_t sourceCrc;
+    uint32_t imageSize;
+    uint32_t imageCrc;
+} ConfigCacheHeader_t;
+
+//config index that tasks read while another one can replace it, see CONFIG_acquire() and CONFIG_publish(). Initialise to all zeros
+typedef struct{
+    Config_t * slots[2];    //the current index and the one that is being replaced
+    uint32_t readers[2];    //number of tasks between CONFIG_acquire() and CONFIG_release() for each slot
+    uint32_t active;        //the slot new readers get
+    uint8_t publishing;     //set while a CONFIG_publish() is running, there can only be one at a time
+} ConfigShared_t;
+
+//pointer to the key and value strings of a Config_t, they start right after the last entry
+#define CONFIG_getStrings(CFG) ((char *) &((CFG)->entries[(CFG)->entryCount]))
+
+//key/value pair found by CONFIG_nextToken(). Both point into the buffer of the tokenizer and are not terminated
+typedef struct{
+    const char * key;
+    uint32_t keyLength;
+    const char * value;
+    uint32_t valueLength;
+} ConfigToken_t;
 
 #if __has_include("ff.h")
 #include "ff.h"
 
+//state of a block reader of CONFIG_initTokenizer()
+typedef struct{
+    FIL * file;
+    char * buffer;
+    uint32_t bufferSize;
+    uint32_t start;         //first char that wasn't tokenized yet
+    uint32_t end;           //end of the data in the buffer
+    uint32_t endOfFile;
+    uint32_t skipLine;      //set while the rest of a line that didn't fit the buffer is skipped
+    uint32_t crc;           //crc32 of everything read so far
+} ConfigTokenizer_t;
+
 char * CONFIG_getKey(FIL * file, char * keyToFind);
+uint32_t CONFIG_getKeys(FIL * file, const char * keys[], size_t n, char * out[]);
+Config_t * CONFIG_load(FIL * file);
+Config_t * CONFIG_loadCached(FIL * file, FIL * cache, uint32_t timestamp);
+uint32_t CONFIG_hasChanged(const Config_t * cfg, FIL * file, uint32_t timestamp);
+uint32_t CONFIG_reload(ConfigShared_t * shared, FIL * file, FIL * cache, uint32_t timestamp);
+uint32_t CONFIG_initTokenizer(ConfigTokenizer_t * tokenizer, FIL * file, char * buffer, uint32_t bufferSize);
+uint32_t CONFIG_nextToken(ConfigTokenizer_t * tokenizer, ConfigToken_t * token);
 #endif
 
-#define PWL_getRowData(PWL, ROW) (&(PWL->data[ROW * (PWL->preComputedDerivative ? 3 : 2)]))
+const char * CONFIG_get(const Config_t * cfg, const char * key);
+void CONFIG_free(Config_t * cfg);
+const Config_t * CONFIG_acquire(ConfigShared_t * shared, uint32_t * slot);
+void CONFIG_release(ConfigShared_t * shared, uint32_t slot);
+void CONFIG_publish(ConfigShared_t * shared, Config_t * cfg);
+
+#define PWL_getRowSize(PWL) ((PWL->type == PWL_TYPE_UNIFORM ? 1 : 2) + (PWL->preComputedDerivative ? 1 : 0))
+//number of fractional bits of the derivative. preciceDerivative=0 is Q0, otherwise slopeShift is used (0 being the original Q8 format so old tables keep working)
+#define PWL_getSlopeShift(PWL) ((PWL)->preciceDerivative ? ((PWL)->slopeShift ? (PWL)->slopeShift : 8) : 0)
+
+//largest slopeShift PWL_computeDerivatives() will choose
+#define PWL_MAX_SLOPE_SHIFT 24
+
+//pointer to a row, only for PWL_ENCODING_INT32
+#define PWL_getRowData(PWL, ROW) (&(PWL->data[(ROW) * PWL_getRowSize(PWL)]))
+
+//PWL_TYPE_POINTS: every row contains its x value. PWL_TYPE_UNIFORM: x of row i is x0 + (i << xStepShift) and isn't stored
+typedef enum{ PWL_TYPE_POINTS, PWL_TYPE_UNIFORM} PwlType_t;
+
+//how the values are stored in memory, see PWL_getY()
+typedef enum{ PWL_ENCODING_INT32, PWL_ENCODING_INT16, PWL_ENCODING_SOA} PwlEncoding_t;
+
+//whether the y values of a PWL strictly rise or fall, needed for PWL_getX(). Set by PWL_checkMonotonicity()
+typedef enum{ PWL_MONOTONIC_UNKNOWN, PWL_MONOTONIC_NO, PWL_MONOTONIC_RISING, PWL_MONOTONIC_FALLING} PwlMonotonicity_t;
+
+//how the memory of a PWL was obtained, so PWL_delete() knows what to free
+//  PWL_STORAGE_SEPARATE: header from the heap, data given to PWL_create() by the caller. PWL_STORAGE_CONTIGUOUS: header and data in one heap block. PWL_STORAGE_STATIC: nothing from the heap
+typedef enum{ PWL_STORAGE_SEPARATE, PWL_STORAGE_CONTIGUOUS, PWL_STORAGE_STATIC} PwlStorage_t;
 
 typedef struct{
     uint32_t listSizeRows; 
     uint32_t preComputedDerivative;
     uint32_t preciceDerivative;
-    int32_t * data;
+    union{
+        int32_t * data;
+        int16_t * data16;   //for PWL_ENCODING_INT16
+    };
+    
+    PwlType_t type;
+    int32_t x0;
+    uint32_t xStepShift;
+    
+    PwlStorage_t storage;
+    PwlEncoding_t encoding;
+    PwlMonotonicity_t monotonicity;
+    uint32_t slopeShift;
 } Pwl_t;
 
-int32_t PWL_getY(int32_t x, Pwl_t * pwl);
+//static initialisers for PWL headers of const tables that are generated at compile time (f.e. with PWL_print()) and stay in flash
+//  usage: static const int32_t myTableData[] = {x0,y0,d0, x1,y1,d1, ...};
+//         static const Pwl_t myTable = PWL_STATIC_INIT(myTableData, 1, 1);
+//  NOTE: the lookup functions never write to the data, the cast only removes the const so the header matches Pwl_t. Never pass such a PWL to PWL_delete()
+#define PWL_STATIC_ROWCOUNT(DATA, ROW_SIZE) (sizeof(DATA) / (sizeof(int32_t) * (ROW_SIZE)))
+
+#define PWL_STATIC_INIT(DATA, PRECOMPUTED_DERIVATIVE, PRECICE_DERIVATIVE) { \
+    .listSizeRows = PWL_STATIC_ROWCOUNT(DATA, (PRECOMPUTED_DERIVATIVE) ? 3 : 2), \
+    .preComputedDerivative = (PRECOMPUTED_DERIVATIVE), \
+    .preciceDerivative = (PRECICE_DERIVATIVE), \
+    .data = (int32_t *) (DATA), \
+    .type = PWL_TYPE_POINTS, \
+    .x0 = 0, \
+    .xStepShift = 0, \
+    .storage = PWL_STORAGE_STATIC, \
+    .encoding = PWL_ENCODING_INT32, \
+    .monotonicity = PWL_MONOTONIC_UNKNOWN, \
+    .slopeShift = 0}
+
+#define PWL_STATIC_INIT_UNIFORM(DATA, X0, X_STEP_SHIFT, PRECOMPUTED_DERIVATIVE, PRECICE_DERIVATIVE) { \
+    .listSizeRows = PWL_STATIC_ROWCOUNT(DATA, (PRECOMPUTED_DERIVATIVE) ? 2 : 1), \
+    .preComputedDerivative = (PRECOMPUTED_DERIVATIVE), \
+    .preciceDerivative = (PRECICE_DERIVATIVE), \
+    .data = (int32_t *) (DATA), \
+    .type = PWL_TYPE_UNIFORM, \
+    .x0 = (X0), \
+    .xStepShift = (X_STEP_SHIFT), \
+    .storage = PWL_STORAGE_STATIC, \
+    .encoding = PWL_ENCODING_INT32, \
+    .monotonicity = PWL_MONOTONIC_UNKNOWN, \
+    .slopeShift = 0}
+
+//same for any type and encoding. DATA must be an array of int16_t for PWL_ENCODING_INT16 and of int32_t otherwise
+//SLOPE_SHIFT is the Q format of the derivative (0 for Q8), MONOTONICITY must match the data if PWL_getX() is used with the table, use PWL_MONOTONIC_UNKNOWN otherwise
+#define PWL_STATIC_INIT_ENCODED(DATA, TYPE, ENCODING, X0, X_STEP_SHIFT, PRECOMPUTED_DERIVATIVE, PRECICE_DERIVATIVE, SLOPE_SHIFT, MONOTONICITY) { \
+    .listSizeRows = sizeof(DATA) / (sizeof(DATA[0]) * (((TYPE) == PWL_TYPE_UNIFORM ? 1 : 2) + ((PRECOMPUTED_DERIVATIVE) ? 1 : 0))), \
+    .preComputedDerivative = (PRECOMPUTED_DERIVATIVE), \
+    .preciceDerivative = (PRECICE_DERIVATIVE), \
+    .data = (int32_t *) (void *) (DATA), \
+    .type = (TYPE), \
+    .x0 = (X0), \
+    .xStepShift = (X_STEP_SHIFT), \
+    .storage = PWL_STORAGE_STATIC, \
+    .encoding = (ENCODING), \
+    .monotonicity = (MONOTONICITY), \
+    .slopeShift = (SLOPE_SHIFT)}
+
+//number of values needed to store ROW_COUNT rows of a PWL, f.e. for the storage of PWL_init() (int16_t's for PWL_ENCODING_INT16, int32_t's otherwise)
+#define PWL_STATIC_DATA_SIZE(TYPE, PRECOMPUTED_DERIVATIVE, ROW_COUNT) ((((TYPE) == PWL_TYPE_UNIFORM ? 1 : 2) + ((PRECOMPUTED_DERIVATIVE) ? 1 : 0)) * (ROW_COUNT))
+
+//printf compatible function used to output generated source code
+typedef int (* PWL_printFunction_t)(const char * format, ...);
+
+//remembers the segment of the last lookup done with PWL_getYCursor()
+typedef struct{
+    uint32_t segment;
+} PwlCursor_t;
+
+int32_t PWL_getY(int32_t x, const Pwl_t * pwl);
+int32_t PWL_getYCursor(int32_t x, const Pwl_t * pwl, PwlCursor_t * cursor);
+void PWL_getYBatch(const int32_t * x, int32_t * y, size_t n, const Pwl_t * pwl);
+int32_t PWL_getX(int32_t y, const Pwl_t * pwl);
+PwlMonotonicity_t PWL_checkMonotonicity(Pwl_t * pwl);
+uint32_t PWL_computeDerivatives(Pwl_t * pwl);
 void PWL_delete(Pwl_t * pwl, uint32_t freeData);
 Pwl_t * PWL_create(int32_t * data, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+Pwl_t * PWL_createUniform(int32_t * data, uint32_t rowCount, int32_t x0, uint32_t xStepShift, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+Pwl_t * PWL_init(Pwl_t * pwl, int32_t * storage, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+Pwl_t * PWL_initUniform(Pwl_t * pwl, int32_t * storage, uint32_t rowCount, int32_t x0, uint32_t xStepShift, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+Pwl_t * PWL_initEncoded(Pwl_t * pwl, void * storage, uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, int32_t x0, uint32_t xStepShift, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+Pwl_t * PWL_convert(const Pwl_t * source, PwlEncoding_t encoding);
+void PWL_print(const Pwl_t * pwl, const char * name, PWL_printFunction_t print);
+
+//two copies of a PWL, lookups use the active one while the other one is changed. See PWL_initDoubleBuffer()
+typedef struct{
+    Pwl_t buffers[2];
+    Pwl_t * active;     //only ever changed with an atomic store
+} PwlDoubleBuffer_t;
+
+//the copy lookups have to use, get it once per lookup
+static inline const Pwl_t * PWL_getActive(const PwlDoubleBuffer_t * table){
+    return __atomic_load_n(&table->active, __ATOMIC_ACQUIRE);
+}
+
+Pwl_t * PWL_initDoubleBuffer(PwlDoubleBuffer_t * table, int32_t * storage, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+Pwl_t * PWL_beginUpdate(PwlDoubleBuffer_t * table);
+uint32_t PWL_commitUpdate(PwlDoubleBuffer_t * table);
+
+
+
+//fractional bits of the position inside a grid cell of a Pwl2D_t
+#define PWL2D_FRACTION_BITS 16
+
+//one axis of a Pwl2D_t
+//  PWL_TYPE_UNIFORM: point i is at x0 + (i << stepShift), points and inverseStep aren't used
+//  PWL_TYPE_POINTS:  points[] holds the ascending coordinates and inverseStep[] 2^31 / (points[i+1] - points[i]) of every segment, so the lookup doesn't need a division
+typedef struct{
+    uint32_t pointCount;
+    PwlType_t type;
+    int32_t x0;
+    uint32_t stepShift;
+    int32_t * points;
+    uint32_t * inverseStep;
+} Pwl2DAxis_t;
+
+//two dimensional grid of z values over an x and a y axis, see PWL2D_get()
+typedef struct{
+    Pwl2DAxis_t xAxis;
+    Pwl2DAxis_t yAxis;
+    int32_t * data;
+    uint32_t preComputedDerivative;
+    PwlStorage_t storage;
+} Pwl2D_t;
+
+#define PWL2D_getPointSize(GRID) ((GRID)->preComputedDerivative ? 4 : 1)
+
+//pointer to the values of grid point (XI, YI), the first one is the z value
+#define PWL2D_getPoint(GRID, XI, YI) (&((GRID)->data[((YI) * (GRID)->xAxis.pointCount + (XI)) * PWL2D_getPointSize(GRID)]))
+
+//static initialisers for const grids, usually generated with PWL2D_print()
+//  usage: static const Pwl2D_t myGrid = PWL2D_STATIC_INIT(myGridData, PWL2D_STATIC_AXIS_POINTS(myGridX, myGridXInverse), PWL2D_STATIC_AXIS_UNIFORM(8, 0, 10), 1);
+//  NOTE: the inverse steps must match the points, compute them with PWL2D_computeDerivatives() and print the grid instead of writing them by hand
+#define PWL2D_STATIC_AXIS_UNIFORM(POINT_COUNT, X0, STEP_SHIFT) { \
+    .pointCount = (POINT_COUNT), \
+    .type = PWL_TYPE_UNIFORM, \
+    .x0 = (X0), \
+    .stepShift = (STEP_SHIFT), \
+    .points = NULL, \
+    .inverseStep = NULL}
+
+#define PWL2D_STATIC_AXIS_POINTS(POINTS, INVERSE_STEPS) { \
+    .pointCount = sizeof(POINTS) / sizeof(int32_t), \
+    .type = PWL_TYPE_POINTS, \
+    .x0 = 0, \
+    .stepShift = 0, \
+    .points = (int32_t *) (POINTS), \
+    .inverseStep = (uint32_t *) (INVERSE_STEPS)}
+
+#define PWL2D_STATIC_INIT(DATA, X_AXIS, Y_AXIS, PRECOMPUTED_DERIVATIVE) { \
+    .xAxis = X_AXIS, \
+    .yAxis = Y_AXIS, \
+    .data = (int32_t *) (DATA), \
+    .preComputedDerivative = (PRECOMPUTED_DERIVATIVE), \
+    .storage = PWL_STORAGE_STATIC}
+
+//number of int32_t's the storage of PWL2D_init() needs
+#define PWL2D_STATIC_AXIS_SIZE(TYPE, POINT_COUNT) (((TYPE) == PWL_TYPE_UNIFORM) ? 0 : 2 * (POINT_COUNT))
+#define PWL2D_STATIC_DATA_SIZE(X_TYPE, X_COUNT, Y_TYPE, Y_COUNT, PRECOMPUTED_DERIVATIVE) \
+    (PWL2D_STATIC_AXIS_SIZE(X_TYPE, X_COUNT) + PWL2D_STATIC_AXIS_SIZE(Y_TYPE, Y_COUNT) + (X_COUNT) * (Y_COUNT) * ((PRECOMPUTED_DERIVATIVE) ? 4 : 1))
+
+int32_t PWL2D_get(int32_t x, int32_t y, const Pwl2D_t * grid);
+void PWL2D_getBatch(const int32_t * x, const int32_t * y, int32_t * z, size_t n, const Pwl2D_t * grid);
+uint32_t PWL2D_computeDerivatives(Pwl2D_t * grid);
+Pwl2D_t * PWL2D_create(PwlType_t xType, uint32_t xCount, PwlType_t yType, uint32_t yCount, uint32_t preComputedDerivative);
+Pwl2D_t * PWL2D_init(Pwl2D_t * grid, int32_t * storage, PwlType_t xType, uint32_t xCount, PwlType_t yType, uint32_t yCount, uint32_t preComputedDerivative);
+void PWL2D_delete(Pwl2D_t * grid);
+void PWL2D_print(const Pwl2D_t * grid, const char * name, PWL_printFunction_t print);
+
 
 
 
 
 
 
+//NTC_MODEL_BETA uses R0, T0 and Beta, NTC_MODEL_STEINHART_HART uses A, B and C (1/T = A + B * ln(R) + C * ln(R)^3)
+typedef enum{ NTC_MODEL_BETA, NTC_MODEL_STEINHART_HART} NTC_Model_t;
 
 typedef struct{
     float R0;
     float T0;
     float Beta;
+    
+    //the model is after the original members, so coefficients initialised with just {R0, T0, Beta} still use the Beta formula
+    NTC_Model_t model;
+    float A;
+    float B;
+    float C;
 } NTC_Coefficients_t;
 
+//NTC_Coefficients_t converted to fixed point by NTC_initFixed(), 1/T values are in 1/K
+typedef struct{
+    NTC_Model_t model;
+    
+    //Beta model
+    int32_t log2R0;         //Q24
+    int64_t inverseT0;      //Q40
+    int64_t ln2OverBeta;    //Q40
+    int64_t betaOverLn2;    //Q16
+    
+    //Steinhart-Hart model
+    int64_t A;              //Q40
+    int64_t B;              //Q40
+    int64_t C;              //Q48
+} NTC_FixedCoefficients_t;
+
+//where the NTC sits in its voltage divider. NTC_DIVIDER_NTC_TO_GROUND: fixed pull-up from the supply to the ADC input, NTC from there to ground. NTC_DIVIDER_NTC_TO_SUPPLY: the other way round
+typedef enum{ NTC_DIVIDER_NTC_TO_GROUND, NTC_DIVIDER_NTC_TO_SUPPLY} NTC_DividerTopology_t;
+
+//NTC voltage divider in front of an ADC, see NTC_generateAdcPWL()
+typedef struct{
+    NTC_DividerTopology_t topology;
+    float fixedResistance;      //the other resistor of the divider
+    float supplyVoltage;        //voltage at the top of the divider and the ADC reference voltage. Leave both at 0 if the divider is supplied from the ADC reference
+    float referenceVoltage;
+    uint32_t adcBits;
+} NTC_Divider_t;
+
+//fractional bits of the filter state of an NTC_Channel_t. Temperatures up to +-2^(31 - NTC_FILTER_FRACTION_BITS) can be filtered
+#define NTC_FILTER_FRACTION_BITS 8
+
+//limits NTC_initChannel() clamps the shifts of a channel to. 2^16 samples of 16 bits are as many as the uint32_t accumulator can hold, 
+//and a filterShift above 31 - NTC_FILTER_FRACTION_BITS would shift even the largest temperature step away completely
+#define NTC_MAX_OVERSAMPLING_SHIFT 16
+#define NTC_MAX_FILTER_SHIFT (31 - NTC_FILTER_FRACTION_BITS)
+
+//state of one channel of NTC_processBlock(), initialise with NTC_initChannel()
+typedef struct{
+    //configuration
+    const Pwl_t * table;
+    uint32_t oversamplingShift;
+    uint32_t filterShift;
+    
+    //state
+    uint32_t accumulator;
+    uint32_t sampleCount;
+    PwlCursor_t cursor;
+    int32_t filterState;
+    
+    //output, temperature is valid once conversionCount isn't 0
+    int32_t temperature;
+    uint32_t conversionCount;
+} NTC_Channel_t;
+
+//Newton steps NTC_getResistanceAtTemperatureFixed() does for the Steinhart-Hart model
+#define NTC_FIXED_ITERATIONS 3
+
+//ln(2) as a double (M_LN2 isn't ISO C) and ln(2) and 1/ln(2) in Q30
+#define NTC_LN2 0.69314718055994530942
+#define NTC_LN2_Q30 744261118LL
+#define NTC_INVERSE_LN2_Q30 1549082005LL
+
 typedef enum{ NTC_MILLI_KELVIN, NTC_MILLI_DEG_CELSIUS, NTC_MILLI_DEG_FAHRENHEIT} NTC_TemperatureUnit_t;
 
 static int32_t NTC_kelvinToUnit(float temperature_K, NTC_TemperatureUnit_t unit);
@@ -44,6 +413,17 @@ static float NTC_unitToKelvin(int32_t temperature, NTC_TemperatureUnit_t unit);
 int32_t NTC_getTemperatureAtResistance(NTC_Coefficients_t * coefficients, float resistance, NTC_TemperatureUnit_t unit);
 float NTC_getResistanceAtTemperature(NTC_Coefficients_t * coefficients, int32_t startTemperature, NTC_TemperatureUnit_t unit);
 Pwl_t * NTC_generatePWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t pointCount, NTC_TemperatureUnit_t unit);
+uint32_t NTC_fillPWL(Pwl_t * pwl, NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, NTC_TemperatureUnit_t unit);
+uint32_t NTC_recalibratePWL(PwlDoubleBuffer_t * table, NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, NTC_TemperatureUnit_t unit);
+Pwl_t * NTC_generateAdaptivePWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, int32_t maxError, NTC_TemperatureUnit_t unit, int32_t * achievedError);
+Pwl_t * NTC_generateUniformPWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, NTC_TemperatureUnit_t unit);
+Pwl_t * NTC_generateAdcPWL(NTC_Coefficients_t * coefficients, const NTC_Divider_t * divider, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, NTC_TemperatureUnit_t unit);
+uint32_t NTC_printAdcPWL(NTC_Coefficients_t * coefficients, const NTC_Divider_t * divider, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, NTC_TemperatureUnit_t unit, const char * name, PWL_printFunction_t print);
+void NTC_initChannel(NTC_Channel_t * channel, const Pwl_t * table, uint32_t oversamplingShift, uint32_t filterShift);
+uint32_t NTC_processBlock(NTC_Channel_t * channels, uint32_t channelCount, const uint16_t * samples, uint32_t samplesPerChannel);
+uint32_t NTC_initFixed(NTC_FixedCoefficients_t * fixed, NTC_Coefficients_t * coefficients);
+int32_t NTC_getTemperatureAtResistanceFixed(const NTC_FixedCoefficients_t * fixed, uint32_t resistance, NTC_TemperatureUnit_t unit);
+uint32_t NTC_getResistanceAtTemperatureFixed(const NTC_FixedCoefficients_t * fixed, int32_t temperature, NTC_TemperatureUnit_t unit);
 
 
 
@@ -51,23 +431,208 @@ Pwl_t * NTC_generatePWL(NTC_Coefficients_t * coefficients, int32_t startTemperat
 
 
 
-int32_t atoiFP(char * a, uint32_t strlen, int32_t baseExponent, uint32_t ignoreUnit);
+//flags of atoiFP_r()
+#define ATOIFP_IGNORE_UNIT 1        //a unit after the number (like "1sec") is skipped instead of being an error
 
+//error codes of atoiFP_r()
+#define ATOIFP_OK 0
+#define ATOIFP_ERROR_NO_NUMBER 1    //the string doesn't start with a number
+#define ATOIFP_ERROR_UNIT 2         //there is something after the number but ATOIFP_IGNORE_UNIT isn't set
+#define ATOIFP_ERROR_OVERFLOW 3     //the number doesn't fit into an int32_t with the given base exponent
 
+int32_t atoiFP(const char * a, uint32_t strlen, int32_t baseExponent, uint32_t ignoreUnit);
+int32_t atoiFP_r(const char * a, size_t len, int32_t baseExponent, uint32_t flags, const char ** end, int * err);
+uint32_t atoiFPList(const char * a, int32_t * values, uint32_t maxCount, const int32_t * baseExponents, uint32_t exponentCount, uint32_t flags, const char ** end, int * err);
 
+//flags of itoaFP()
+#define ITOAFP_DIGITS_MASK 0xf
+#define ITOAFP_DIGITS(N) ((N) & ITOAFP_DIGITS_MASK)    //round to N significant digits (1 to 9), 0 prints all digits
+#define ITOAFP_NO_PREFIX 0x10                           //plain decimal number without an SI prefix
 
+uint32_t itoaFP(int32_t value, int32_t baseExponent, char * buf, size_t len, uint32_t flags);
 
+int32_t CONFIG_getInt(const Config_t * cfg, const char * key, int32_t baseExponent, int32_t defaultValue);
+uint32_t CONFIG_getBool(const Config_t * cfg, const char * key, uint32_t defaultValue);
+Pwl_t * CONFIG_getPwl(const Config_t * cfg, const char * key, int32_t xExponent, int32_t yExponent);
 
 
+
+
+
+
+
+//1.0 in the Q30 format of qSin32() and friends
+#define QSIN_ONE (1L << 30)
+
+//segments of the quarter wave table, the lower 30 - 7 bits of the phase in a quarter are interpolated
+#define QSIN_TABLE_SIZE 128
+#define QSIN_FRACTION_BITS 23
+
 int32_t qSin(int32_t x);
+int32_t qSin32(uint32_t phase);
+int32_t qCos32(uint32_t phase);
+void qSinCos32(uint32_t phase, int32_t * sine, int32_t * cosine);
+
+//phase step of a qOsc_t for a frequency at a sample rate (both in Hz or any other matching unit)
+#define QOSC_PHASE_STEP(FREQUENCY, SAMPLE_RATE) ((uint32_t) (((uint64_t) (FREQUENCY) << 32) / (SAMPLE_RATE)))
+
+//120deg of phase, the offset between the outputs of a three phase qOsc_t
+#define QOSC_THIRD_PERIOD 1431655765UL
+
+//state of a sine oscillator, see qOsc_init()
+typedef struct{
+    uint32_t phase;             //2^32 = 2pi
+    uint32_t phaseStep;         //phase increment per sample
+    uint32_t targetPhaseStep;   //phaseStep at the end of the next block
+    int32_t amplitude;          //amplitude at the end of the last block
+    int32_t offset;
+    uint32_t phaseCount;        //1 or 3 interleaved outputs
+} qOsc_t;
+
+void qOsc_init(qOsc_t * osc, uint32_t phaseStep, uint32_t phaseCount, int32_t offset);
+void qOsc_setFrequency(qOsc_t * osc, uint32_t phaseStep);
+uint32_t qOsc_fill(qOsc_t * osc, int32_t * buf, size_t n, int32_t amplitudeQ);
+
+//iterations of the CORDIC of qAtan2() and qMag(), every one adds about one bit of precision. QCORDIC_INVERSE_GAIN is 1/1.6468 (the gain of those iterations) in Q32
+#define QCORDIC_ITERATIONS 24
+#define QCORDIC_INVERSE_GAIN 2608131496ULL
+
+uint32_t qAtan2(int32_t y, int32_t x);
+uint32_t qMag(int32_t x, int32_t y);
+uint32_t qSqrt(uint32_t x);
+
+//benchmarks of the hot paths, only there if util.c is built with UTIL_BENCHMARK defined
+#ifdef UTIL_BENCHMARK
+void UTIL_benchmark(PWL_printFunction_t print);
+#if __has_include("ff.h")
+void CONFIG_benchmark(FIL * scratch, PWL_printFunction_t print);
+#endif
+#endif
+
+//trace levels for UTIL_TRACE_LEVEL, every trace above the level compiles to nothing
+#define UTIL_TRACE_OFF 0
+#define UTIL_TRACE_ERROR 1      //something failed, f.e. a file access
+#define UTIL_TRACE_INFO 2       //things that happen rarely, like a config cache being used or rebuilt
+#define UTIL_TRACE_DEBUG 3      //every key lookup and parser error, only for bring-up
+#ifndef UTIL_TRACE_LEVEL
+#define UTIL_TRACE_LEVEL UTIL_TRACE_ERROR
+#endif
+
+//where the text traces go, TTerm's debug output unless something else is defined at compile time. Without TTerm they just disappear
+#ifndef UTIL_TRACE_PRINT
+#if __has_include("TTerm.h")
+#include "TTerm.h"
+#define UTIL_TRACE_PRINT(...) TERM_printDebug(TERM_handle, __VA_ARGS__)
+#else
+#define UTIL_TRACE_PRINT(...) ((void) 0)
+#endif
+#endif
+
+//the trace of each level is chosen here, so the ones above UTIL_TRACE_LEVEL are ((void) 0) and their arguments are never even looked at by the compiler
+#if UTIL_TRACE_LEVEL >= UTIL_TRACE_ERROR
+#define UTIL_TRACE_AT_UTIL_TRACE_ERROR(...) UTIL_TRACE_PRINT(__VA_ARGS__)
+#else
+#define UTIL_TRACE_AT_UTIL_TRACE_ERROR(...) ((void) 0)
+#endif
+#if UTIL_TRACE_LEVEL >= UTIL_TRACE_INFO
+#define UTIL_TRACE_AT_UTIL_TRACE_INFO(...) UTIL_TRACE_PRINT(__VA_ARGS__)
+#else
+#define UTIL_TRACE_AT_UTIL_TRACE_INFO(...) ((void) 0)
+#endif
+#if UTIL_TRACE_LEVEL >= UTIL_TRACE_DEBUG
+#define UTIL_TRACE_AT_UTIL_TRACE_DEBUG(...) UTIL_TRACE_PRINT(__VA_ARGS__)
+#else
+#define UTIL_TRACE_AT_UTIL_TRACE_DEBUG(...) ((void) 0)
+#endif
+
+//printf style trace. The formatting happens right there in the caller, so keep it out of anything time critical.
+//LEVEL must be one of the UTIL_TRACE_* names above (not a number or a variable), it selects the macro
+#define UTIL_trace(LEVEL, ...) UTIL_TRACE_AT_##LEVEL(__VA_ARGS__)
+
+//number of events the trace ring buffer keeps, must be a power of two. 0 removes the buffer and all event traces
+#ifndef UTIL_TRACE_EVENT_COUNT
+#define UTIL_TRACE_EVENT_COUNT 32
+#endif
+
+//events of the ring buffer and what their two arguments are
+typedef enum{
+    UTIL_EVENT_NONE = 0,
+    UTIL_EVENT_CONFIG_KEY_FOUND,        //key length, value length
+    UTIL_EVENT_CONFIG_KEY_MISSING,      //key hash, entry count of the index
+    UTIL_EVENT_CONFIG_SEEK_FAILED,      //FRESULT, -
+    UTIL_EVENT_CONFIG_READ_FAILED,      //FRESULT, -
+    UTIL_EVENT_CONFIG_CACHE_HIT,        //source size, source crc
+    UTIL_EVENT_CONFIG_CACHE_MISS,       //source size, source crc
+    UTIL_EVENT_CONFIG_CACHE_WRITE_FAILED,   //image size, -
+    UTIL_EVENT_ATOIFP_ERROR,            //ATOIFP_ERROR_*, string length
+    UTIL_EVENT_PWL_INVALID,             //row count, -
+    UTIL_EVENT_COUNT
+} UTIL_TraceEventId_t;
+
+//one entry of the ring buffer
+typedef struct{
+    uint32_t timestamp;     //UTIL_getCycles() when it was recorded
+    uint32_t id;            //UTIL_TraceEventId_t
+    int32_t arg0;
+    int32_t arg1;
+} UTIL_TraceEvent_t;
+
+//binary trace, stores the id and two numbers in the ring buffer and nothing else. UTIL_printTraceEvents() formats them later
+#if UTIL_TRACE_EVENT_COUNT > 0
+//same level selection as UTIL_trace(), the events above UTIL_TRACE_LEVEL are ((void) 0)
+#define UTIL_traceEvent(LEVEL, ID, ARG0, ARG1) UTIL_TRACE_AT_##LEVEL##_EVENT(ID, (int32_t) (ARG0), (int32_t) (ARG1))
+#if UTIL_TRACE_LEVEL >= UTIL_TRACE_ERROR
+#define UTIL_TRACE_AT_UTIL_TRACE_ERROR_EVENT(ID, ARG0, ARG1) UTIL_recordEvent(ID, ARG0, ARG1)
+#else
+#define UTIL_TRACE_AT_UTIL_TRACE_ERROR_EVENT(ID, ARG0, ARG1) ((void) 0)
+#endif
+#if UTIL_TRACE_LEVEL >= UTIL_TRACE_INFO
+#define UTIL_TRACE_AT_UTIL_TRACE_INFO_EVENT(ID, ARG0, ARG1) UTIL_recordEvent(ID, ARG0, ARG1)
+#else
+#define UTIL_TRACE_AT_UTIL_TRACE_INFO_EVENT(ID, ARG0, ARG1) ((void) 0)
+#endif
+#if UTIL_TRACE_LEVEL >= UTIL_TRACE_DEBUG
+#define UTIL_TRACE_AT_UTIL_TRACE_DEBUG_EVENT(ID, ARG0, ARG1) UTIL_recordEvent(ID, ARG0, ARG1)
+#else
+#define UTIL_TRACE_AT_UTIL_TRACE_DEBUG_EVENT(ID, ARG0, ARG1) ((void) 0)
+#endif
+
+void UTIL_recordEvent(uint32_t id, int32_t arg0, int32_t arg1);
+uint32_t UTIL_getTraceEvents(UTIL_TraceEvent_t * events, uint32_t maxCount);
+void UTIL_printTraceEvents(PWL_printFunction_t print);
+#else
+#define UTIL_traceEvent(LEVEL, ID, ARG0, ARG1) ((void) 0)
+#endif
+
+
+
+
+
 
 
+//classes of a char in utilCharTable, the low byte holds the value of a digit or the exponent of a multiplier
+#define UTIL_CHAR_DIGIT         0x0100
+#define UTIL_CHAR_MULTIPLIER    0x0200  //SI prefixes and the dot (exponent 0)
+#define UTIL_CHAR_SPECIAL       0x0400  //anything below 32 and above 127
+#define UTIL_CHAR_SPACE         0x0800  //spaces and special characters, they separate the tokens of a config line
+#define UTIL_CHAR_SEPARATOR     0x1000  //space, comma, semicolon and tab, they separate the values of a list
 
+extern const uint16_t utilCharTable[256];
 
+//digit value or exponent of a char, only valid if it is a digit or a multiplier
+#define UTIL_getCharValue(C) ((int8_t) (utilCharTable[(uint8_t) (C)] & 0xff))
 
+static inline uint32_t isAsciiNumber(char c){
+    return (utilCharTable[(uint8_t) c] & UTIL_CHAR_DIGIT) != 0;
+}
 
+static inline uint32_t isAsciiSpecialCharacter(char c){
+    return (utilCharTable[(uint8_t) c] & UTIL_CHAR_SPECIAL) != 0;
+}
 
-uint32_t isAsciiNumber(char c);
-uint32_t isAsciiSpecialCharacter(char c);
+//SI prefix (f, p, n, u, m, c, d, h, k, M, G, T, P) or the dot
+static inline uint32_t isAsciiMultiplier(char c){
+    return (utilCharTable[(uint8_t) c] & UTIL_CHAR_MULTIPLIER) != 0;
+}
 
 #endif
\ No newline at end of file
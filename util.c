@@ -2,17 +2,352 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
+#ifdef UTIL_BENCHMARK
+#include <stdio.h>
+#endif
 
 #if __has_include("ff.h")
 #include "ff.h"
 #endif
 
-//#if __has_include("TTerm.h")
-#include "TTerm.h"
-//#endif
-
 #include "include/util.h"
-#include "../Users/tzethoff/Documents/MPLabProjects/SpeedBox.X/FreeRTOS/Core/include/portable.h"
+
+//memory for the PWLs and configs: FreeRTOS heap if there is one, the static arena below otherwise. UTIL_MALLOC and UTIL_FREE can also be defined to anything else at compile time
+#ifndef UTIL_MALLOC
+#if __has_include("FreeRTOS.h")
+#include "FreeRTOS.h"
+#include "portable.h"
+#define UTIL_DEFAULT_MALLOC pvPortMalloc
+#define UTIL_DEFAULT_FREE vPortFree
+#else
+#define UTIL_DEFAULT_MALLOC UTIL_arenaMalloc
+#define UTIL_DEFAULT_FREE UTIL_arenaFree
+#endif
+
+#define UTIL_MALLOC(SIZE) utilMalloc(SIZE)
+#define UTIL_FREE(PTR) utilFree(PTR)
+#endif
+
+//lets lower priority tasks run while CONFIG_publish() waits for the readers of the old index. Without an RTOS it just spins
+#if __has_include("FreeRTOS.h")
+#include "FreeRTOS.h"
+#include "task.h"
+#define UTIL_yield() vTaskDelay(1)
+#else
+#define UTIL_yield() ((void) 0)
+#endif
+
+static inline int32_t PWL_lookup(int32_t x, const Pwl_t * pwl);
+static inline int32_t PWL_getValue(const Pwl_t * pwl, uint32_t row, uint32_t column);
+static inline uint32_t PWL_setValue(Pwl_t * pwl, uint32_t row, uint32_t column, int32_t value);
+static inline int32_t PWL_getPointX(const Pwl_t * pwl, uint32_t row);
+static inline int32_t PWL_getPointY(const Pwl_t * pwl, uint32_t row);
+static inline int32_t PWL_getPointDerivative(const Pwl_t * pwl, uint32_t row);
+static uint32_t PWL_findRow(int32_t x, const Pwl_t * pwl);
+static inline uint32_t PWL_searchInt32(int32_t x, const int32_t * column, uint32_t stride, uint32_t count, const uint32_t descending);
+static inline uint32_t PWL_searchInt16(int32_t x, const int16_t * column, uint32_t stride, uint32_t count, const uint32_t descending);
+static uint32_t PWL_findRowY(int32_t y, const Pwl_t * pwl, const uint32_t descending);
+static uint32_t PWL_findSegment(int32_t x, const Pwl_t * pwl);
+static inline uint32_t PWL_rowToSegment(uint32_t row, uint32_t rowCount);
+static inline int32_t PWL_interpolate(int32_t x, const Pwl_t * pwl, uint32_t segment);
+static int32_t PWL_getYUniform(int32_t x, const Pwl_t * pwl);
+static inline void PWL_getYBatchPoints(const int32_t * x, int32_t * y, size_t n, const Pwl_t * pwl, const uint32_t preComputedDerivative, const uint32_t preciceDerivative);
+static inline void PWL_getYBatchUniform(const int32_t * x, int32_t * y, size_t n, const Pwl_t * pwl, const uint32_t preComputedDerivative, const uint32_t preciceDerivative);
+static Pwl_t * PWL_allocate(void * data, uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+static void PWL_initHeader(Pwl_t * pwl, void * data, uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, uint32_t preComputedDerivative, uint32_t preciceDerivative);
+static uint32_t PWL_getDataSize(uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, uint32_t preComputedDerivative);
+static uint32_t PWL_getSegmentSlopeShift(const Pwl_t * pwl, uint32_t row, uint32_t maxShift, int64_t limit);
+static uint32_t PWL_computeSegmentDerivative(Pwl_t * pwl, uint32_t row, int64_t limit);
+static void PWL_swapBuffers(PwlDoubleBuffer_t * table, Pwl_t * shadow);
+static inline uint32_t PWL2D_findSegment(int32_t x, const Pwl2DAxis_t * axis, uint32_t hint, int32_t * fraction);
+static inline int32_t PWL2D_interpolate(const Pwl2D_t * grid, uint32_t xSegment, uint32_t ySegment, int32_t xFraction, int32_t yFraction);
+static int32_t NTC_getSegmentError(NTC_Coefficients_t * coefficients, int32_t startResistance, int32_t endResistance, NTC_TemperatureUnit_t unit, int32_t * worstResistance);
+static int32_t NTC_getPwlError(const Pwl_t * pwl, NTC_Coefficients_t * coefficients, NTC_TemperatureUnit_t unit);
+static float NTC_getDividerScale(const NTC_Divider_t * divider);
+static float NTC_getResistanceAtAdcCount(const NTC_Divider_t * divider, float count);
+static float NTC_getAdcCountAtResistance(const NTC_Divider_t * divider, float resistance);
+static int32_t NTC_log2Fixed(uint32_t x);
+static uint32_t CONFIG_hash(const char * key, uint32_t length);
+static uint32_t CONFIG_findHash(const ConfigEntry_t * entries, uint32_t count, uint32_t hash);
+static const char * CONFIG_getRow(const Config_t * cfg, const char * key, uint32_t row, char * rowKey);
+static inline uint32_t isListSeparator(char c);
+static inline uint32_t itoaFP_countDigits(uint32_t x);
+static void itoaFP_writeDigits(uint32_t x, char * digits, uint32_t count);
+static uint32_t CONFIG_equalsIgnoreCase(const char * a, const char * b);
+static const ConfigEntry_t * CONFIG_findEntry(const Config_t * cfg, const char * key);
+static inline char atoiFP_peek(const char * a, size_t len, size_t i);
+static int atoiFP_parse(const char * a, size_t len, uint32_t flags, const char ** end, int64_t * mantissa, int32_t * exponent, uint32_t * truncated);
+static int32_t atoiFP_scale(int64_t mantissa, int32_t exponent, uint32_t truncated, int * err);
+#if __has_include("ff.h")
+static uint32_t CONFIG_findComment(const char * line, uint32_t length);
+static uint32_t CONFIG_tokenizeLine(const char * line, uint32_t length, ConfigToken_t * token);
+static inline uint32_t CONFIG_isSpace(char c);
+static int CONFIG_compareEntries(const void * a, const void * b);
+static uint32_t CONFIG_crc32(uint32_t crc, const void * data, uint32_t length);
+static void CONFIG_parseValue(ConfigEntry_t * entry, const char * value);
+static uint32_t CONFIG_getFileCrc(FIL * file, uint32_t * crc);
+static Config_t * CONFIG_readCache(FIL * cache, FIL * file, uint32_t sourceTimestamp);
+static uint32_t CONFIG_writeCache(FIL * cache, const Config_t * cfg);
+#endif
+static uint32_t NTC_exp2Fixed(int64_t x);
+static int32_t NTC_milliKelvinToUnit(int64_t temperature_mK, NTC_TemperatureUnit_t unit);
+static int64_t NTC_unitToMilliKelvin(int32_t temperature, NTC_TemperatureUnit_t unit);
+static inline int32_t qSinQuarter(uint32_t phase);
+static inline int32_t qOsc_getSample(uint32_t phase, int32_t amplitude, int32_t offset);
+static void qCordicVector(int32_t x, int32_t y, uint32_t * angle, uint32_t * magnitude);
+
+#ifdef UTIL_DEFAULT_MALLOC
+//the allocator everything in here uses, see UTIL_setAllocator()
+static UTIL_mallocFunction_t utilMalloc = UTIL_DEFAULT_MALLOC;
+static UTIL_freeFunction_t utilFree = UTIL_DEFAULT_FREE;
+#endif
+
+/*
+ * replaces the allocator used by the PWL, NTC and CONFIG functions, f.e. with a memory pool or malloc() and free() on a host
+ * 
+ * usage: call once before anything is created, memory from one allocator must never be freed with the other one
+ * 
+ *      the default is the FreeRTOS heap if FreeRTOS.h can be found, otherwise a static arena of UTIL_ARENA_SIZE bytes
+ * 
+ *      NOTE: does nothing if UTIL_MALLOC and UTIL_FREE are defined at compile time, those always win
+ */
+void UTIL_setAllocator(UTIL_mallocFunction_t mallocFunction, UTIL_freeFunction_t freeFunction){
+#ifdef UTIL_DEFAULT_MALLOC
+    if(mallocFunction == NULL || freeFunction == NULL) return;
+    utilMalloc = mallocFunction;
+    utilFree = freeFunction;
+#else
+    (void) mallocFunction;
+    (void) freeFunction;
+#endif
+}
+
+/*
+ * default allocator without an RTOS: hands out pieces of a static buffer of UTIL_ARENA_SIZE bytes
+ * 
+ * every block starts with a small header that holds its size, so UTIL_arenaFree() can give it back. A freed block is reused by the next allocation 
+ * that fits into it (together with any free blocks right after it), if it was the last one it goes straight back to the end of the arena. 
+ * That way the block buffers CONFIG_getKey() and CONFIG_load() need while they run don't pile up even if the values they return are kept. 
+ * With UTIL_ARENA_SIZE = 0 nothing can be allocated at all, then every PWL must be static or get its memory from PWL_init()
+ * 
+ *      NOTE: not thread safe, only allocate from one task (or before the scheduler starts)
+ *      NOTE: there is no compaction, lots of blocks of changing sizes that are freed in random order can still fragment the arena
+ */
+#if UTIL_ARENA_SIZE > 0
+typedef struct{
+    uint32_t size;      //bytes after the header, always a multiple of 8
+    uint32_t free;
+} UtilArenaBlock_t;
+
+//uint64_t so everything in it is aligned for any type
+static uint64_t arena[(UTIL_ARENA_SIZE + 7) / 8];
+static size_t arenaUsed = 0;
+#endif
+
+void * UTIL_arenaMalloc(size_t size){
+#if UTIL_ARENA_SIZE > 0
+    size = (size + 7) & ~(size_t) 7;
+    if(size == 0 || size > sizeof(arena)) return NULL;
+    
+    //first look for a freed block that is large enough
+    size_t offset = 0;
+    while(offset < arenaUsed){
+        UtilArenaBlock_t * block = (UtilArenaBlock_t *) ((uint8_t *) arena + offset);
+        size_t next = offset + sizeof(UtilArenaBlock_t) + block->size;
+        
+        if(!block->free){
+            offset = next;
+            continue;
+        }
+        
+        //merge all free blocks after this one into it
+        while(next < arenaUsed && ((UtilArenaBlock_t *) ((uint8_t *) arena + next))->free){
+            block->size += sizeof(UtilArenaBlock_t) + ((UtilArenaBlock_t *) ((uint8_t *) arena + next))->size;
+            next = offset + sizeof(UtilArenaBlock_t) + block->size;
+        }
+        
+        //nothing but free space after this, that can just go back to the end
+        if(next >= arenaUsed){
+            arenaUsed = offset;
+            break;
+        }
+        
+        if(block->size >= size){
+            //split off whatever is left if another block fits into it
+            if(block->size - size >= sizeof(UtilArenaBlock_t) + 8){
+                UtilArenaBlock_t * rest = (UtilArenaBlock_t *) ((uint8_t *) block + sizeof(UtilArenaBlock_t) + size);
+                rest->size = block->size - size - sizeof(UtilArenaBlock_t);
+                rest->free = 1;
+                block->size = size;
+            }
+            
+            block->free = 0;
+            return block + 1;
+        }
+        
+        offset = next;
+    }
+    
+    //nothing to reuse, append a new block at the end
+    if(size + sizeof(UtilArenaBlock_t) > sizeof(arena) - arenaUsed) return NULL;
+    
+    UtilArenaBlock_t * block = (UtilArenaBlock_t *) ((uint8_t *) arena + arenaUsed);
+    block->size = size;
+    block->free = 0;
+    arenaUsed += sizeof(UtilArenaBlock_t) + size;
+    return block + 1;
+#else
+    (void) size;
+    return NULL;
+#endif
+}
+
+void UTIL_arenaFree(void * ptr){
+#if UTIL_ARENA_SIZE > 0
+    if(ptr == NULL) return;
+    
+    UtilArenaBlock_t * block = (UtilArenaBlock_t *) ptr - 1;
+    block->free = 1;
+    
+    //the last block goes back to the end right away
+    if((uint8_t *) ptr + block->size == (uint8_t *) arena + arenaUsed) arenaUsed -= sizeof(UtilArenaBlock_t) + block->size;
+#else
+    (void) ptr;
+#endif
+}
+
+//total number of bytes util.c got from its allocator since startup, see UTIL_getAllocatedBytes()
+static size_t utilAllocatedBytes = 0;
+
+//every allocation of util.c goes through here so it can be counted
+static void * utilAllocate(size_t size){
+    void * ret = UTIL_MALLOC(size);
+    if(ret != NULL) utilAllocatedBytes += size;
+    return ret;
+}
+
+//nothing is subtracted when memory is freed again (the size isn't known then), so the difference before and after a call is what it allocated
+size_t UTIL_getAllocatedBytes(void){
+    return utilAllocatedBytes;
+}
+
+/*
+ * the allocator util.c uses, whichever one that is in this build (FreeRTOS heap, the arena, UTIL_setAllocator() or UTIL_MALLOC/UTIL_FREE)
+ * 
+ * usage: free everything util.c hands out to be freed by the caller (f.e. the values of CONFIG_getKey() and CONFIG_getKeys()) with UTIL_free()
+ */
+void * UTIL_malloc(size_t size){
+    return utilAllocate(size);
+}
+
+void UTIL_free(void * ptr){
+    if(ptr == NULL) return;
+    UTIL_FREE(ptr);
+}
+
+//cycle counter of the Cortex-M3 and up (DWT->CYCCNT), the M0 doesn't have one
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__)
+#define UTIL_DEMCR (*(volatile uint32_t *) 0xE000EDFC)
+#define UTIL_DWT_CTRL (*(volatile uint32_t *) 0xE0001000)
+#define UTIL_DWT_CYCCNT (*(volatile uint32_t *) 0xE0001004)
+#define UTIL_HAS_DWT 1
+#endif
+
+/*
+ * time base for measuring how long something takes: CPU cycles on a Cortex-M3 or bigger, nanoseconds on a host with clock_gettime(). Always 0 if neither is available
+ * 
+ * usage: call UTIL_initCycleCounter() once, then the difference of two UTIL_getCycles() is the time in between. It wraps around after 2^32 (43s at 100MHz, 4.3s on a host)
+ * 
+ *      NOTE: the debugger may use the DWT too, UTIL_initCycleCounter() only turns it on and never off
+ */
+void UTIL_initCycleCounter(void){
+#ifdef UTIL_HAS_DWT
+    UTIL_DEMCR |= 1UL << 24;    //TRCENA, powers the DWT
+    UTIL_DWT_CYCCNT = 0;
+    UTIL_DWT_CTRL |= 1;         //CYCCNTENA
+#endif
+}
+
+uint32_t UTIL_getCycles(void){
+#if defined(UTIL_HAS_DWT)
+    return UTIL_DWT_CYCCNT;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) now.tv_sec * 1000000000UL + (uint32_t) now.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+#if UTIL_TRACE_EVENT_COUNT > 0
+#if (UTIL_TRACE_EVENT_COUNT & (UTIL_TRACE_EVENT_COUNT - 1)) != 0
+#error "UTIL_TRACE_EVENT_COUNT must be a power of two"
+#endif
+
+//ring buffer of the event traces. traceHead counts every event ever recorded, traceTail the ones that were read already
+static UTIL_TraceEvent_t traceEvents[UTIL_TRACE_EVENT_COUNT];
+static volatile uint32_t traceHead = 0;
+static uint32_t traceTail = 0;
+
+/*
+ * stores one event in the trace ring buffer. Usually called through UTIL_traceEvent(), so it disappears with the trace level
+ * 
+ * usage: nothing is formatted, it only takes a timestamp and copies the arguments. When the buffer is full the oldest events get overwritten
+ * 
+ *      NOTE: if an interrupt records an event while a task is in the middle of one, one of them can end up garbled. Nothing outside of the buffer is ever touched though
+ */
+void UTIL_recordEvent(uint32_t id, int32_t arg0, int32_t arg1){
+    //take the slot first, so anything interrupting us most likely gets the next one
+    uint32_t head = traceHead++;
+    UTIL_TraceEvent_t * event = &traceEvents[head & (UTIL_TRACE_EVENT_COUNT - 1)];
+    
+    event->timestamp = UTIL_getCycles();
+    event->id = id;
+    event->arg0 = arg0;
+    event->arg1 = arg1;
+}
+
+/*
+ * copies up to maxCount events that weren't read yet into events, oldest first
+ * 
+ * usage: call from a low priority task (or a terminal command) and do the formatting there, or just use UTIL_printTraceEvents()
+ *      returns the number of events copied, 0 once the buffer is empty
+ * 
+ *      NOTE: only one reader at a time
+ */
+uint32_t UTIL_getTraceEvents(UTIL_TraceEvent_t * events, uint32_t maxCount){
+    if(events == NULL) return 0;
+    
+    uint32_t head = traceHead;
+    
+    //anything more than one buffer length back was overwritten already
+    if(head - traceTail > UTIL_TRACE_EVENT_COUNT) traceTail = head - UTIL_TRACE_EVENT_COUNT;
+    
+    uint32_t count = 0;
+    while(traceTail != head && count < maxCount){
+        events[count++] = traceEvents[traceTail & (UTIL_TRACE_EVENT_COUNT - 1)];
+        traceTail++;
+    }
+    
+    return count;
+}
+
+//prints all events that weren't read yet with their names, one per line
+void UTIL_printTraceEvents(PWL_printFunction_t print){
+    static const char * const names[UTIL_EVENT_COUNT] = {
+        "none", "config key found", "config key missing", "config seek failed", "config read failed",
+        "config cache hit", "config cache miss", "config cache write failed", "atoiFP error", "pwl invalid"
+    };
+    
+    UTIL_TraceEvent_t event;
+    while(UTIL_getTraceEvents(&event, 1)){
+        const char * name = (event.id < UTIL_EVENT_COUNT) ? names[event.id] : "unknown";
+        print("%10lu %-26s %ld %ld\r\n", (unsigned long) event.timestamp, name, (long) event.arg0, (long) event.arg1);
+    }
+}
+#endif
 
 /*
  * peicewise linear function algorithm, allows for fast lut implementations
@@ -31,261 +366,3361 @@
  *      {xValue,yValue,dY/dX}
  *      - x/yValue: as in preComputedDerivative=0
  *      - dY/dX: pre-computed rate of change in between the point and the next one in the list
+ * 
+ * preciceDerivative means the derivative is a fixed point number with slopeShift fractional bits (dY/dX * 2^slopeShift). 
+ * slopeShift=0 is the original format of dY/dX * 256 (Q8), PWL_computeDerivatives() chooses the largest shift (up to PWL_MAX_SLOPE_SHIFT) that fits the table
  *  
  *      NOTE: the list must be sorted by x values in ascending order (x[0] < x[1] < x[2]...)
+ *      NOTE: for PWLs of type PWL_TYPE_UNIFORM the rows don't contain the xValue, see PWL_createUniform()
+ * 
+ * PWL encodings:
+ *   PWL_ENCODING_INT32: rows of int32_t's one after the other {x0,y0,d0, x1,y1,d1, ...} (the default)
+ *   PWL_ENCODING_INT16: same as PWL_ENCODING_INT32 but with int16_t values
+ *   PWL_ENCODING_SOA:   int32_t columns one after the other {x0,x1,..., y0,y1,..., d0,d1,...}, so the search only touches the x array
+ *      use PWL_convert() or PWL_initEncoded() to create these
+ * 
  *      NOTE: if you need this to be fast, make sure to pre-calculate the derivatives as this saves a division for every conversion
+ *      NOTE: the neighbouring points are found with a binary search, so a lookup takes log2(listSizeRows) compares. Use PWL_getYCursor() if consecutive x values are close together
  */
-int32_t PWL_getY(int32_t x, Pwl_t * pwl){
+int32_t PWL_getY(int32_t x, const Pwl_t * pwl){
     //check if we even got a PWL
     if(pwl == NULL) return 0;
     
     if(pwl->listSizeRows < 2){
         //can't approximate any function if all we have is a single point. We need at least two
         //configASSERT(0);
+        UTIL_traceEvent(UTIL_TRACE_DEBUG, UTIL_EVENT_PWL_INVALID, pwl->listSizeRows, 0);
         return 0;
     }
     
-    int32_t * currentRow = NULL;
-    int32_t * lastRow = NULL;
+    return PWL_lookup(x, pwl);
+}
+
+/*
+ * the actual lookup behind PWL_getY(), without the checks of the PWL
+ */
+static inline int32_t PWL_lookup(int32_t x, const Pwl_t * pwl){
+    //uniform PWLs don't need a search at all, the segment can be calculated directly from x
+    if(pwl->type == PWL_TYPE_UNIFORM) return PWL_getYUniform(x, pwl);
+    
+    //find the first row with an x value that is not smaller than the one we are looking for
+    uint32_t row = PWL_findRow(x, pwl);
+    
+    //check if by any chance x exactly matches the value in the row
+    if(row < pwl->listSizeRows && PWL_getPointX(pwl, row) == x){
+        //oh yes actually it does => just return the y value
+        return PWL_getPointY(pwl, row);
+    }
+    
+    //no exact match, interpolate between the row left of x and the one we found
+    return PWL_interpolate(x, pwl, PWL_rowToSegment(row, pwl->listSizeRows));
+}
+
+/*
+ * Same as PWL_getY() but remembers the segment that was used for the last lookup in the cursor
+ * 
+ * usage: create one cursor per input signal (zero initialised, f.e. "PwlCursor_t cursor = {0};") and pass it to every conversion of that signal.
+ *        The segment of the last conversion and its two neighbours are checked before falling back to the binary search, 
+ *        so slowly changing inputs (like a sensor reading) are converted without any search at all.
+ * 
+ *      NOTE: a cursor may be shared between different PWLs, it just won't speed anything up then
+ *      NOTE: a cursor is not thread safe, don't use the same one from two tasks or from a task and an ISR
+ */
+int32_t PWL_getYCursor(int32_t x, const Pwl_t * pwl, PwlCursor_t * cursor){
+    //no cursor given? Just do a normal lookup then
+    if(cursor == NULL) return PWL_getY(x, pwl);
+    
+    //check if we even got a PWL
+    if(pwl == NULL) return 0;
+    
+    //can't approximate any function if all we have is a single point. We need at least two
+    if(pwl->listSizeRows < 2) return 0;
     
-    //find the neighbouring points
-    int32_t entry = 0;
-    for(entry = 0; entry < pwl->listSizeRows; entry++){
-        //calculate data pointer to current row. If preComputedDiff is on then there is a third value in the row (dX/dY between the current and next entry) otherwise only 2
-        currentRow = (pwl->data) + entry * (pwl->preComputedDerivative ? 3 : 2);
-        
-        //check if by any chance x exactly matches the value in the row
-        if(currentRow[0] == x){
-            //oh yes actually it does => just return the y value
-            return currentRow[1];
+    //uniform PWLs don't search for the segment, so there is nothing the cursor could help with
+    if(pwl->type == PWL_TYPE_UNIFORM) return PWL_getYUniform(x, pwl);
+    
+    uint32_t lastSegment = pwl->listSizeRows - 2;
+    
+    //make sure the cursor actually points into this table (it might have been used with a larger one before)
+    uint32_t segment = cursor->segment;
+    if(segment > lastSegment) segment = lastSegment;
+    
+    //is x still inside the segment we used last time? (the first and last segments extend to infinity as we extrapolate with them)
+    if(segment > 0 && x < PWL_getPointX(pwl, segment)){
+        //no, x moved to the left. Check if it is in the previous segment, otherwise we need to search for it
+        if(segment == 1 || x >= PWL_getPointX(pwl, segment - 1)){
+            segment--;
+        }else{
+            segment = PWL_findSegment(x, pwl);
         }
         
-        //check if the entry we are looking at has a x value larger than the one we are looking for
-        if(currentRow[0] > x){
-            //entry found :)
+    }else if(segment < lastSegment && x >= PWL_getPointX(pwl, segment + 1)){
+        //no, x moved to the right. Check if it is in the next segment, otherwise we need to search for it
+        if(segment + 1 == lastSegment || x < PWL_getPointX(pwl, segment + 2)){
+            segment++;
+        }else{
+            segment = PWL_findSegment(x, pwl);
+        }
+    }
+    
+    cursor->segment = segment;
+    
+    //x exactly on the last point would otherwise be extrapolated from the segment in front of it, return the exact y value just like PWL_getY() does
+    if(segment == lastSegment && PWL_getPointX(pwl, segment + 1) == x) return PWL_getPointY(pwl, segment + 1);
+    
+    //x exactly on the start point of a segment is handled by the interpolation, localX will be zero
+    return PWL_interpolate(x, pwl, segment);
+}
+
+/*
+ * reads a single value of a row, independent of the encoding of the PWL. column is the position of the value in the row format (see PWL_getY())
+ */
+static inline int32_t PWL_getValue(const Pwl_t * pwl, uint32_t row, uint32_t column){
+    switch(pwl->encoding){
+        case PWL_ENCODING_INT16:
+            return pwl->data16[row * PWL_getRowSize(pwl) + column];
             
-            //check if we are at the first entry in the list
-            if(lastRow == NULL){ 
-                //yes we are, that means that the x value we are looking for lies outside the boundary of the pwl. Try to interpolate with the first two points
-                
-                //is there at least one point ahead of us?
-                if(entry + 1 >= pwl->listSizeRows){
-                    //hmm no, this shouldn't technically be possible as we already check for a list size of at least 2. just return, we can't do any calculations now anyway
-                    
-                    //this btw means that we are left of the first point in the graph, but no other point exists after the first one (aka we only have one in total)
-                    return 0;
-                }
-                
-                //change the pointers to point to the correct points
-                lastRow     = currentRow;
-                currentRow  = (pwl->data) + (entry + 1) * (pwl->preComputedDerivative ? 3 : 2);
-                
-                break;
-            }
+        case PWL_ENCODING_SOA:
+            //every column is its own array of listSizeRows values
+            return pwl->data[column * pwl->listSizeRows + row];
             
-            //point found in list, no change to pointers needed
-            break;
-        }
-        
-        //entry not yet found, update last point
-        lastRow = currentRow;
+        default:
+            return pwl->data[row * PWL_getRowSize(pwl) + column];
+    }
+}
+
+//same as PWL_getValue() but writes the value. Returns 0 if the value doesn't fit the encoding
+static inline uint32_t PWL_setValue(Pwl_t * pwl, uint32_t row, uint32_t column, int32_t value){
+    switch(pwl->encoding){
+        case PWL_ENCODING_INT16:
+            if(value < INT16_MIN || value > INT16_MAX) return 0;
+            pwl->data16[row * PWL_getRowSize(pwl) + column] = value;
+            return 1;
+            
+        case PWL_ENCODING_SOA:
+            pwl->data[column * pwl->listSizeRows + row] = value;
+            return 1;
+            
+        default:
+            pwl->data[row * PWL_getRowSize(pwl) + column] = value;
+            return 1;
+    }
+}
+
+//x, y and dY/dX of a point. Uniform PWLs don't store x and so the other values move one column to the left
+static inline int32_t PWL_getPointX(const Pwl_t * pwl, uint32_t row){
+    if(pwl->type == PWL_TYPE_UNIFORM) return pwl->x0 + (int32_t) (row << pwl->xStepShift);
+    return PWL_getValue(pwl, row, 0);
+}
+
+static inline int32_t PWL_getPointY(const Pwl_t * pwl, uint32_t row){
+    return PWL_getValue(pwl, row, (pwl->type == PWL_TYPE_UNIFORM) ? 0 : 1);
+}
+
+static inline int32_t PWL_getPointDerivative(const Pwl_t * pwl, uint32_t row){
+    return PWL_getValue(pwl, row, (pwl->type == PWL_TYPE_UNIFORM) ? 1 : 2);
+}
+
+/*
+ * binary search for the first row with an x value >= x (equivalent to the std::lower_bound)
+ * 
+ * returns listSizeRows if all points are left of x
+ */
+static uint32_t PWL_findRow(int32_t x, const Pwl_t * pwl){
+    //the search only needs the x values, so we can do it directly on the x column. For SoA PWLs that is just an array
+    switch(pwl->encoding){
+        case PWL_ENCODING_INT16:
+            return PWL_searchInt16(x, pwl->data16, PWL_getRowSize(pwl), pwl->listSizeRows, 0);
+            
+        case PWL_ENCODING_SOA:
+            return PWL_searchInt32(x, pwl->data, 1, pwl->listSizeRows, 0);
+            
+        default:
+            return PWL_searchInt32(x, pwl->data, PWL_getRowSize(pwl), pwl->listSizeRows, 0);
     }
+}
+
+//lower bound search on a column with a distance of stride values between the elements
+//if descending is set the column is sorted in descending order and the first element <= x is returned instead
+static inline uint32_t PWL_searchInt32(int32_t x, const int32_t * column, uint32_t stride, uint32_t count, const uint32_t descending){
+    uint32_t first = 0;
     
-    //check if there was no entry in the list larger than the x we are looking for. If so just use the maximum possible value for calculation.
-    if(lastRow == currentRow){
-        //this means loop exited due to entry == pwl.listSizeRows. Move lastRow back one entry
+    //halve the range we are looking at until there is nothing left
+    while(count > 0){
+        uint32_t half = count >> 1;
+        int32_t value = column[(first + half) * stride];
         
-        //can we actually do that?
-        if(entry - 2 < 0){
-            //hmm no, this again means there is only one point in the list... can't do anything
-            return 0;
+        if(descending ? (value > x) : (value < x)){
+            //the middle point is still left of x, continue in the upper half
+            first += half + 1;
+            count -= half + 1;
+        }else{
+            //the middle point is right of x (or exactly on it), continue in the lower half
+            count = half;
         }
+    }
+    
+    return first;
+}
+
+//same as PWL_searchInt32() for int16_t columns
+static inline uint32_t PWL_searchInt16(int32_t x, const int16_t * column, uint32_t stride, uint32_t count, const uint32_t descending){
+    uint32_t first = 0;
+    
+    while(count > 0){
+        uint32_t half = count >> 1;
+        int32_t value = column[(first + half) * stride];
         
-        lastRow = (pwl->data) + (entry-2) * (pwl->preComputedDerivative ? 3 : 2);
+        if(descending ? (value > x) : (value < x)){
+            first += half + 1;
+            count -= half + 1;
+        }else{
+            count = half;
+        }
     }
     
-    //now interpolate between the two points pointed to by lastRow (start point, left of X) and currentRow (end point, right of x))
+    return first;
+}
+
+/*
+ * returns the segment whose start point is the last one left of or exactly on x (extrapolation segments for x outside of the PWL)
+ */
+static uint32_t PWL_findSegment(int32_t x, const Pwl_t * pwl){
+    uint32_t row = PWL_findRow(x, pwl);
+    
+    //x exactly on a point? Then that point is the start of the segment, unless it is the very last one
+    if(row < pwl->listSizeRows - 1 && PWL_getPointX(pwl, row) == x) return row;
+    
+    return PWL_rowToSegment(row, pwl->listSizeRows);
+}
+
+/*
+ * returns the segment (the number of its start point) that is used to interpolate a value left of the given row
+ * 
+ * if row is the first one (x is left of the first point) or past the last one (x is right of the last point) the first or last segment is used to extrapolate
+ */
+static inline uint32_t PWL_rowToSegment(uint32_t row, uint32_t rowCount){
+    if(row == 0) return 0;
+    if(row >= rowCount) return rowCount - 2;
+    return row - 1;
+}
+
+/*
+ * interpolate between the start point of the segment (left of x) and its end point (right of x)
+ */
+static inline int32_t PWL_interpolate(int32_t x, const Pwl_t * pwl, uint32_t segment){
+    int32_t startX = PWL_getPointX(pwl, segment);
             
-    //first calculate the x offset from the start point
-    int32_t localX = x - lastRow[0];
-    int32_t localY = lastRow[1];        
+    //first calculate the x offset from the start point. The difference of two int32's doesn't always fit an int32, so that is done in 64 bits too
+    int64_t localX = (int64_t) x - startX;
+    int32_t localY = PWL_getPointY(pwl, segment);        
+
+    uint32_t slopeShift = PWL_getSlopeShift(pwl);
 
     //calculate derivative of pwl between start and end points
-    int32_t dYdX = 0;
+    int64_t dYdX = 0;
     if(pwl->preComputedDerivative){
         //nothing to compute, just read the value from the start point dataset
-        dYdX = lastRow[2];
+        dYdX = PWL_getPointDerivative(pwl, segment);
     }else{
-        int32_t dy = (currentRow[1] - lastRow[1]) * (pwl->preciceDerivative ? 256 : 1);
-        int32_t dx = currentRow[0] - lastRow[0];
+        //multiplied instead of shifted, dy can be negative
+        int64_t dy = ((int64_t) PWL_getPointY(pwl, segment + 1) - localY) * (1LL << slopeShift);
+        int64_t dx = (int64_t) PWL_getPointX(pwl, segment + 1) - startX;
         if(dx != 0) dYdX = dy / dx; else dYdX = 0;
     }
 
     //calculate linear function as 
     //   y = m     *   x       + b         with m=dYdX, x=localX, b=localY
-    // option "preciceDerivative" means the derivative value given is multiplied by 256
-    return  (pwl->preciceDerivative ? ((dYdX   *   localX) >> 8)  :  (dYdX  *   localX))  + localY;
+    // the derivative is multiplied by 2^slopeShift, the product and the sum are calculated in 64 bits so neither can overflow
+    return  (int32_t) (((dYdX   *   localX) >> slopeShift)  + localY);
 }
 
-/* 
- * Function to allocate PWL memory
- * 
- * note: 
- *      if data=NULL will cause the function to try to allocate suitably sized memory for it aswell.
- *      You can specify a data pointer if you want something like a dynamically allocated header but a const dataset
+/*
+ * lookup for PWLs of type PWL_TYPE_UNIFORM. The segment index is just (x - x0) >> xStepShift
  */
-Pwl_t * PWL_create(int32_t * data, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+static int32_t PWL_getYUniform(int32_t x, const Pwl_t * pwl){
+    uint32_t lastSegment = pwl->listSizeRows - 2;
     
-//try to allocate pwl header memory
-    Pwl_t * pwl = pvPortMalloc(sizeof(Pwl_t));
-    if(pwl == NULL) return NULL;    //didn't work => don't even try to continue
-    
-    pwl->listSizeRows = rowCount;
-    pwl->preComputedDerivative = preComputedDerivative;
-    pwl->preciceDerivative = preciceDerivative;
+    //64 bits, x and x0 can be more than INT32_MAX apart
+    int64_t offset = (int64_t) x - pwl->x0;
+    uint32_t segment = 0;
     
-//do we need to allocate data memory?
-    if(data == NULL){
-        //yes! => try to do so (*3 is for the row size of three int32's)
-        pwl->data = pvPortMalloc(sizeof(int32_t) * (preComputedDerivative ? 3 : 2) * rowCount);
+    //is x right of the first point? Otherwise we extrapolate with the first segment
+    if(offset > 0){
+        uint64_t offsetSegment = (uint64_t) offset >> pwl->xStepShift;
         
-        if(pwl->data == NULL){ 
-            vPortFree(pwl);
-            return NULL;    //didn't work => don't even try to continue
+        if(offsetSegment > lastSegment){
+            //x is on or right of the last point. Return the exact value if it is on it, otherwise extrapolate with the last segment
+            if(offsetSegment == lastSegment + 1 && (offset & ((1 << pwl->xStepShift) - 1)) == 0) return PWL_getPointY(pwl, lastSegment + 1);
+            offsetSegment = lastSegment;
         }
-    }else{
-        //no. Just assign the data the caller gave us
-        pwl->data = data;
+        segment = (uint32_t) offsetSegment;
     }
     
-    return pwl;
+    int32_t startY = PWL_getPointY(pwl, segment);
+    
+    //x offset from the start point of the segment
+    int64_t localX = offset - ((int64_t) segment << pwl->xStepShift);
+    
+    //row format is {yValue} or {yValue,dY/dX}
+    if(pwl->preComputedDerivative){
+        int32_t dYdX = PWL_getPointDerivative(pwl, segment);
+        return  (int32_t) (((dYdX   *   localX) >> PWL_getSlopeShift(pwl))  + startY);
+    }else{
+        //dx is a power of two, so instead of calculating the derivative we can just divide the product by shifting
+        int64_t dy = (int64_t) PWL_getPointY(pwl, segment + 1) - startY;
+        return (int32_t) (((dy * localX) >> pwl->xStepShift) + startY);
+    }
 }
 
-/* 
- * Function to free a PWLs memory
+/*
+ * inverse of PWL_getY(), returns the x value at which the PWL has the value y
+ * 
+ * usage: only works with PWLs whose y values strictly rise or fall (pwl->monotonicity is PWL_MONOTONIC_RISING or PWL_MONOTONIC_FALLING), 0 is returned otherwise.
+ *        The monotonicity is checked once when the PWL is created or generated (see PWL_checkMonotonicity()), not on every call.
+ *        The y column is searched just like the x column in PWL_getY() and y values outside of the PWL are extrapolated with the first or last segment.
+ * 
+ *      NOTE: if the derivative is pre computed it is used for the inversion, so PWL_getX(PWL_getY(x)) returns x (within the rounding of the derivative)
+ *      NOTE: this always needs one division
  */
-void PWL_delete(Pwl_t * pwl, uint32_t freeData){
-    //is there anything to free?
-    if(pwl == NULL) return;
+int32_t PWL_getX(int32_t y, const Pwl_t * pwl){
+    //check if we even got a PWL, and if it can be inverted at all
+    if(pwl == NULL || pwl->listSizeRows < 2) return 0;
+    if(pwl->monotonicity != PWL_MONOTONIC_RISING && pwl->monotonicity != PWL_MONOTONIC_FALLING) return 0;
     
-    //do we need to free the data? If yes then do so
-    if(freeData) vPortFree(pwl->data);
+    //find the first point that is on or past y
+    uint32_t row = PWL_findRowY(y, pwl, pwl->monotonicity == PWL_MONOTONIC_FALLING);
     
-    //free the header
-    vPortFree(pwl);
+    //exact match? Then we already have the x value
+    if(row < pwl->listSizeRows && PWL_getPointY(pwl, row) == y) return PWL_getPointX(pwl, row);
+    
+    uint32_t segment = PWL_rowToSegment(row, pwl->listSizeRows);
+    int32_t startX = PWL_getPointX(pwl, segment);
+    int64_t localY = (int64_t) y - PWL_getPointY(pwl, segment);
+    
+    if(pwl->preComputedDerivative){
+        //invert y = dYdX * localX + startY
+        int32_t dYdX = PWL_getPointDerivative(pwl, segment);
+        if(dYdX == 0) return startX;
+        
+        return (int32_t) (startX + (localY * (1LL << PWL_getSlopeShift(pwl))) / dYdX);
+    }else{
+        //no derivative available, calculate the x offset with the points directly
+        int64_t dy = (int64_t) PWL_getPointY(pwl, segment + 1) - PWL_getPointY(pwl, segment);
+        int64_t dx = (int64_t) PWL_getPointX(pwl, segment + 1) - startX;
+        
+        //can't happen in a strictly monotonic PWL, but better safe than sorry
+        if(dy == 0) return startX;
+        
+        return (int32_t) (startX + (localY * dx) / dy);
+    }
 }
 
-
-
-
-
-
-
+/*
+ * same as PWL_findRow() but searches the y column, in the direction given by descending
+ */
+static uint32_t PWL_findRowY(int32_t y, const Pwl_t * pwl, const uint32_t descending){
+    uint32_t yColumn = (pwl->type == PWL_TYPE_UNIFORM) ? 0 : 1;
+    
+    switch(pwl->encoding){
+        case PWL_ENCODING_INT16:
+            return PWL_searchInt16(y, pwl->data16 + yColumn, PWL_getRowSize(pwl), pwl->listSizeRows, descending);
+            
+        case PWL_ENCODING_SOA:
+            return PWL_searchInt32(y, pwl->data + yColumn * pwl->listSizeRows, 1, pwl->listSizeRows, descending);
+            
+        default:
+            return PWL_searchInt32(y, pwl->data + yColumn, PWL_getRowSize(pwl), pwl->listSizeRows, descending);
+    }
+}
 
 /*
- * NTC Tool - generates a PWL with a specified number of rows that allows for faster conversion of resistance to temperature
- *      TODO: not sure if we actually need this, but it might be useful: NOTE: for conversion of divider ratio to resistance check NTC_calculateNTCResistance()
+ * calculates the pre computed derivative of every row from the points of the PWL
  * 
- * usage: 
- *      specify NTC parameters with ntcBaseResistance (f.e. 10k) and the coefficients (available in the datasheet, sometimes called A,B & C instead of a0,a1 & a2)
- *      List size is determined by the start & endTemperature (I recommend only specifying the temperature region of interest to you here to increase accuracy) and the point Count. Use at least (TODO: figure out how many points are recommended lol)
- *      select the unit of the PWL with the 
+ * if preciceDerivative is set the largest slopeShift (up to PWL_MAX_SLOPE_SHIFT) is chosen for which the steepest segment still fits the encoding. 
+ * A slope so steep that it doesn't even fit with one fractional bit turns preciceDerivative off
+ * 
+ * returns 0 if the PWL has no derivative column or if a slope doesn't fit the encoding at all
+ */
+uint32_t PWL_computeDerivatives(Pwl_t * pwl){
+    if(pwl == NULL || !pwl->preComputedDerivative || pwl->listSizeRows < 2) return 0;
+    
+    int64_t limit = (pwl->encoding == PWL_ENCODING_INT16) ? INT16_MAX : INT32_MAX;
+    uint32_t slopeShift = 0;
+    
+    //find the largest shift that all slopes fit with
+    if(pwl->preciceDerivative){
+        slopeShift = PWL_MAX_SLOPE_SHIFT;
+        for(uint32_t row = 0; row + 1 < pwl->listSizeRows && slopeShift > 0; row++) slopeShift = PWL_getSegmentSlopeShift(pwl, row, slopeShift, limit);
+        
+        //slopeShift=0 with preciceDerivative would mean the original Q8 format, so switch to the non precice format instead
+        if(slopeShift == 0) pwl->preciceDerivative = 0;
+    }
+    
+    pwl->slopeShift = slopeShift;
+    
+    uint32_t ret = 1;
+    for(uint32_t row = 0; row + 1 < pwl->listSizeRows; row++){
+        if(!PWL_computeSegmentDerivative(pwl, row, limit)) ret = 0;
+    }
+    
+    //we don't need a derivative for the very last row of the PWL as it is never used
+    PWL_setValue(pwl, pwl->listSizeRows - 1, PWL_getRowSize(pwl) - 1, 0);
+    
+    return ret;
+}
+
+//largest shift up to maxShift with which the slope of the segment starting at row fits into limit
+static uint32_t PWL_getSegmentSlopeShift(const Pwl_t * pwl, uint32_t row, uint32_t maxShift, int64_t limit){
+    int64_t dy = llabs((int64_t) PWL_getPointY(pwl, row + 1) - PWL_getPointY(pwl, row));
+    int64_t dx = (int64_t) PWL_getPointX(pwl, row + 1) - PWL_getPointX(pwl, row);
+    if(dx <= 0) return maxShift;
+    
+    //+dx/2 for the rounding in PWL_computeSegmentDerivative()
+    uint32_t slopeShift = maxShift;
+    while(slopeShift > 0 && ((dy * (1LL << slopeShift)) + dx / 2) / dx > limit) slopeShift--;
+    return slopeShift;
+}
+
+//stores the derivative of the segment starting at row with the slopeShift of the PWL, returns 0 if it had to be clipped to fit
+static uint32_t PWL_computeSegmentDerivative(Pwl_t * pwl, uint32_t row, int64_t limit){
+    int64_t dy = ((int64_t) PWL_getPointY(pwl, row + 1) - PWL_getPointY(pwl, row)) * (1LL << pwl->slopeShift);
+    int64_t dx = (int64_t) PWL_getPointX(pwl, row + 1) - PWL_getPointX(pwl, row);
+    
+    //round to the nearest value instead of truncating, that halves the error the derivative causes
+    int64_t dYdX = 0;
+    if(dx > 0) dYdX = (dy + ((dy < 0) ? -dx / 2 : dx / 2)) / dx;
+    
+    uint32_t ret = 1;
+    if(dYdX > limit || dYdX < -limit - 1){
+        dYdX = (dYdX > 0) ? limit : -limit - 1;
+        ret = 0;
+    }
+    
+    PWL_setValue(pwl, row, PWL_getRowSize(pwl) - 1, (int32_t) dYdX);
+    return ret;
+}
+
+/*
+ * checks whether the y values of a PWL strictly rise or fall and stores the result in pwl->monotonicity (which PWL_getX() needs)
+ * 
+ * this is done automatically by the NTC generators, PWL_convert() and PWL_create()/PWL_createUniform() if they get data. 
+ * Call it yourself after filling the rows of a PWL that was created without data or with PWL_init()
+ */
+PwlMonotonicity_t PWL_checkMonotonicity(Pwl_t * pwl){
+    if(pwl == NULL) return PWL_MONOTONIC_NO;
+    
+    PwlMonotonicity_t result = PWL_MONOTONIC_NO;
+    
+    if(pwl->listSizeRows >= 2){
+        //the first segment decides in which direction we are going, all others must go the same way
+        int32_t lastY = PWL_getPointY(pwl, 0);
+        int32_t currentY = PWL_getPointY(pwl, 1);
+        
+        if(currentY != lastY){
+            result = (currentY > lastY) ? PWL_MONOTONIC_RISING : PWL_MONOTONIC_FALLING;
+            
+            for(uint32_t row = 2; row < pwl->listSizeRows; row++){
+                lastY = currentY;
+                currentY = PWL_getPointY(pwl, row);
+                
+                if(result == PWL_MONOTONIC_RISING ? (currentY <= lastY) : (currentY >= lastY)){
+                    result = PWL_MONOTONIC_NO;
+                    break;
+                }
+            }
+        }
+    }
+    
+    pwl->monotonicity = result;
+    return result;
+}
+
+/*
+ * Converts a whole buffer of x values with the same PWL, f.e. a DMA buffer of ADC samples
+ * 
+ * usage: y[i] = PWL_getY(x[i], pwl) for i = 0 ... n-1, the results are identical. x and y may point to the same buffer
+ * 
+ *      NOTE: all checks of the PWL and its row format are done once per call instead of once per sample, each row format of PWL_ENCODING_INT32 has its own loop
+ *      NOTE: if the PWL is invalid (NULL or less than two rows) y is filled with zeros, just like PWL_getY() would return
+ */
+void PWL_getYBatch(const int32_t * x, int32_t * y, size_t n, const Pwl_t * pwl){
+    //check if we even got a PWL, and enough points to approximate anything
+    if(pwl == NULL || pwl->listSizeRows < 2){
+        for(size_t i = 0; i < n; i++) y[i] = 0;
+        return;
+    }
+    
+    //the specialised loops are for the int32_t interleaved encoding, the others are converted one by one (but still without checking the PWL for every sample)
+    if(pwl->encoding != PWL_ENCODING_INT32){
+        for(size_t i = 0; i < n; i++) y[i] = PWL_lookup(x[i], pwl);
+        return;
+    }
+    
+    //select the loop matching the row format. The format flags are constants in each of the calls so the compiler can generate a specialised loop for each one
+    if(pwl->type == PWL_TYPE_UNIFORM){
+        if(pwl->preComputedDerivative){
+            if(pwl->preciceDerivative) PWL_getYBatchUniform(x, y, n, pwl, 1, 1); else PWL_getYBatchUniform(x, y, n, pwl, 1, 0);
+        }else{
+            PWL_getYBatchUniform(x, y, n, pwl, 0, 0);
+        }
+    }else{
+        if(pwl->preComputedDerivative){
+            if(pwl->preciceDerivative) PWL_getYBatchPoints(x, y, n, pwl, 1, 1); else PWL_getYBatchPoints(x, y, n, pwl, 1, 0);
+        }else{
+            if(pwl->preciceDerivative) PWL_getYBatchPoints(x, y, n, pwl, 0, 1); else PWL_getYBatchPoints(x, y, n, pwl, 0, 0);
+        }
+    }
+}
+
+/*
+ * batch loop for PWL_TYPE_POINTS, see PWL_getY() for how the lookup works. preComputedDerivative and preciceDerivative must be constants
+ */
+static inline void PWL_getYBatchPoints(const int32_t * x, int32_t * y, size_t n, const Pwl_t * pwl, const uint32_t preComputedDerivative, const uint32_t preciceDerivative){
+    const uint32_t rowSize = preComputedDerivative ? 3 : 2;
+    const uint32_t rowCount = pwl->listSizeRows;
+    const uint32_t slopeShift = preciceDerivative ? PWL_getSlopeShift(pwl) : 0;
+    const int32_t * data = pwl->data;
+    
+    for(size_t i = 0; i < n; i++){
+        int32_t currentX = x[i];
+        
+        //binary search for the first row with an x value >= currentX, same as PWL_findRow()
+        uint32_t first = 0;
+        uint32_t count = rowCount;
+        while(count > 0){
+            uint32_t half = count >> 1;
+            if(data[(first + half) * rowSize] < currentX){
+                first += half + 1;
+                count -= half + 1;
+            }else{
+                count = half;
+            }
+        }
+        
+        //exact match? Then just copy the y value
+        if(first < rowCount && data[first * rowSize] == currentX){
+            y[i] = data[first * rowSize + 1];
+            continue;
+        }
+        
+        const int32_t * lastRow = &data[PWL_rowToSegment(first, rowCount) * rowSize];
+        int64_t localX = (int64_t) currentX - lastRow[0];
+        
+        int64_t dYdX;
+        if(preComputedDerivative){
+            dYdX = lastRow[2];
+        }else{
+            int64_t dx = (int64_t) lastRow[rowSize] - lastRow[0];
+            dYdX = (dx != 0) ? (((int64_t) lastRow[rowSize + 1] - lastRow[1]) * (1LL << slopeShift)) / dx : 0;
+        }
+        
+        y[i] = (int32_t) (((dYdX * localX) >> slopeShift) + lastRow[1]);
+    }
+}
+
+/*
+ * batch loop for PWL_TYPE_UNIFORM, see PWL_getYUniform() for how the lookup works. preComputedDerivative and preciceDerivative must be constants
+ */
+static inline void PWL_getYBatchUniform(const int32_t * x, int32_t * y, size_t n, const Pwl_t * pwl, const uint32_t preComputedDerivative, const uint32_t preciceDerivative){
+    const uint32_t rowSize = preComputedDerivative ? 2 : 1;
+    const uint32_t lastSegment = pwl->listSizeRows - 2;
+    const uint32_t stepShift = pwl->xStepShift;
+    const int32_t stepMask = (1 << stepShift) - 1;
+    const int32_t x0 = pwl->x0;
+    const uint32_t slopeShift = preciceDerivative ? PWL_getSlopeShift(pwl) : 0;
+    const int32_t * data = pwl->data;
+    
+    for(size_t i = 0; i < n; i++){
+        int64_t offset = (int64_t) x[i] - x0;
+        uint32_t segment = 0;
+        
+        if(offset > 0){
+            uint64_t offsetSegment = (uint64_t) offset >> stepShift;
+            
+            if(offsetSegment > lastSegment){
+                //exactly on the last point?
+                if(offsetSegment == lastSegment + 1 && (offset & stepMask) == 0){
+                    y[i] = data[(lastSegment + 1) * rowSize];
+                    continue;
+                }
+                offsetSegment = lastSegment;
+            }
+            segment = (uint32_t) offsetSegment;
+        }
+        
+        const int32_t * lastRow = &data[segment * rowSize];
+        int64_t localX = offset - ((int64_t) segment << stepShift);
+        
+        if(preComputedDerivative){
+            y[i] = (int32_t) ((((int64_t) lastRow[1] * localX) >> slopeShift) + lastRow[0]);
+        }else{
+            y[i] = (int32_t) (((((int64_t) lastRow[rowSize] - lastRow[0]) * localX) >> stepShift) + lastRow[0]);
+        }
+    }
+}
+
+/* 
+ * Function to allocate PWL memory
+ * 
+ * note: 
+ *      if data=NULL will cause the function to try to allocate suitably sized memory for it aswell. Header and data are then allocated as a single block
+ *      You can specify a data pointer if you want something like a dynamically allocated header but a const dataset
+ *      If you don't want to use the heap at all use PWL_init() instead
+ */
+Pwl_t * PWL_create(int32_t * data, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    return PWL_allocate(data, rowCount, PWL_TYPE_POINTS, PWL_ENCODING_INT32, preComputedDerivative, preciceDerivative);
+}
+
+static Pwl_t * PWL_allocate(void * data, uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    //size of the rows, in case we need to allocate them too
+    uint32_t dataSize = (data == NULL) ? PWL_getDataSize(rowCount, type, encoding, preComputedDerivative) : 0;
+    
+//try to allocate pwl header memory. If we need memory for the data too it goes into the same block right after the header, so there is only one allocation to fragment the heap
+    Pwl_t * pwl = utilAllocate(sizeof(Pwl_t) + dataSize);
+    if(pwl == NULL) return NULL;    //didn't work => don't even try to continue
+    
+    //the data (if we allocated it) starts right after the header. sizeof(Pwl_t) is a multiple of 4 so it is correctly aligned for the int32_t's
+    PWL_initHeader(pwl, (data == NULL) ? (void *) (pwl + 1) : data, rowCount, type, encoding, preComputedDerivative, preciceDerivative);
+    
+    //remember how we got the memory, PWL_delete() needs to know that
+    pwl->storage = (data == NULL) ? PWL_STORAGE_CONTIGUOUS : PWL_STORAGE_SEPARATE;
+    
+    //if we got data we can already check whether the PWL can be inverted. (Uniform PWLs also need x0 and the step for that, but those don't change the y values)
+    if(data != NULL) PWL_checkMonotonicity(pwl);
+    
+    return pwl;
+}
+
+static void PWL_initHeader(Pwl_t * pwl, void * data, uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    pwl->listSizeRows = rowCount;
+    pwl->preComputedDerivative = preComputedDerivative;
+    pwl->preciceDerivative = preciceDerivative;
+    pwl->data = data;
+    pwl->type = type;
+    pwl->x0 = 0;
+    pwl->xStepShift = 0;
+    pwl->storage = PWL_STORAGE_STATIC;
+    pwl->encoding = encoding;
+    pwl->monotonicity = PWL_MONOTONIC_UNKNOWN;
+    pwl->slopeShift = 0;
+}
+
+//number of bytes the rows of a PWL need
+static uint32_t PWL_getDataSize(uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, uint32_t preComputedDerivative){
+    return PWL_STATIC_DATA_SIZE(type, preComputedDerivative, rowCount) * ((encoding == PWL_ENCODING_INT16) ? sizeof(int16_t) : sizeof(int32_t));
+}
+
+/* 
+ * Function to initialise a PWL in memory owned by the caller, the heap is never touched
+ * 
+ * usage: 
+ *      Pwl_t myPwl;
+ *      int32_t myPwlData[PWL_STATIC_DATA_SIZE(PWL_TYPE_POINTS, 1, ROW_COUNT)];
+ *      PWL_init(&myPwl, myPwlData, ROW_COUNT, 1, 1);
+ * 
+ *      storage must have space for rowCount rows of the selected format, see PWL_getY() for the row format
+ *      
+ *      NOTE: a PWL created with this must not be passed to PWL_delete() (it will just be ignored if you do)
+ */
+Pwl_t * PWL_init(Pwl_t * pwl, int32_t * storage, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    if(pwl == NULL || storage == NULL) return NULL;
+    
+    PWL_initHeader(pwl, storage, rowCount, PWL_TYPE_POINTS, PWL_ENCODING_INT32, preComputedDerivative, preciceDerivative);
+    return pwl;
+}
+
+/* 
+ * same as PWL_init() but for a PWL_TYPE_UNIFORM PWL, see PWL_createUniform()
+ */
+Pwl_t * PWL_initUniform(Pwl_t * pwl, int32_t * storage, uint32_t rowCount, int32_t x0, uint32_t xStepShift, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    return PWL_initEncoded(pwl, storage, rowCount, PWL_TYPE_UNIFORM, PWL_ENCODING_INT32, x0, xStepShift, preComputedDerivative, preciceDerivative);
+}
+
+/* 
+ * same as PWL_init() but with all options of the PWL format, see PWL_getY() for the encodings
+ * 
+ * storage must have space for PWL_STATIC_DATA_SIZE(type, preComputedDerivative, rowCount) values (int16_t for PWL_ENCODING_INT16 and int32_t otherwise)
+ * x0 and xStepShift are only used by PWL_TYPE_UNIFORM
+ */
+Pwl_t * PWL_initEncoded(Pwl_t * pwl, void * storage, uint32_t rowCount, PwlType_t type, PwlEncoding_t encoding, int32_t x0, uint32_t xStepShift, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    if(pwl == NULL || storage == NULL || xStepShift > 30) return NULL;
+    
+    PWL_initHeader(pwl, storage, rowCount, type, encoding, preComputedDerivative, preciceDerivative);
+    
+    if(type == PWL_TYPE_UNIFORM){
+        pwl->x0 = x0;
+        pwl->xStepShift = xStepShift;
+    }
+    return pwl;
+}
+
+/* 
+ * creates a copy of a PWL with a different encoding (f.e. to turn a generated NTC table into a PWL_ENCODING_INT16 one)
+ * 
+ * returns NULL if there was no memory available or if any of the values doesn't fit into the new encoding. Derivatives that don't fit are recalculated with a smaller slopeShift
+ */
+Pwl_t * PWL_convert(const Pwl_t * source, PwlEncoding_t encoding){
+    if(source == NULL) return NULL;
+    
+    Pwl_t * pwl = PWL_allocate(NULL, source->listSizeRows, source->type, encoding, source->preComputedDerivative, source->preciceDerivative);
+    if(pwl == NULL) return NULL;
+    
+    pwl->x0 = source->x0;
+    pwl->xStepShift = source->xStepShift;
+    pwl->monotonicity = source->monotonicity;
+    pwl->slopeShift = source->slopeShift;
+    
+    //copy every value of every row over. The derivatives are recalculated afterwards if they have to be, as they might need a smaller slopeShift to fit
+    uint32_t rowSize = PWL_getRowSize(source);
+    uint32_t valueColumns = source->preComputedDerivative ? rowSize - 1 : rowSize;
+    uint32_t derivativesFit = 1;
+    
+    for(uint32_t row = 0; row < source->listSizeRows; row++){
+        for(uint32_t column = 0; column < valueColumns; column++){
+            if(!PWL_setValue(pwl, row, column, PWL_getValue(source, row, column))){
+                //doesn't fit :( 
+                PWL_delete(pwl, 0);
+                return NULL;
+            }
+        }
+        
+        if(source->preComputedDerivative && !PWL_setValue(pwl, row, rowSize - 1, PWL_getPointDerivative(source, row))) derivativesFit = 0;
+    }
+    
+    if(!derivativesFit && !PWL_computeDerivatives(pwl)){
+        PWL_delete(pwl, 0);
+        return NULL;
+    }
+    
+    return pwl;
+}
+
+/* 
+ * initialises a double buffered PWL, which can be changed while an interrupt keeps doing lookups with it. The heap is never touched
+ * 
+ * usage: 
+ *      PwlDoubleBuffer_t myTable;
+ *      int32_t myTableData[2 * PWL_STATIC_DATA_SIZE(PWL_TYPE_POINTS, 1, ROW_COUNT)];
+ *      PWL_initDoubleBuffer(&myTable, myTableData, ROW_COUNT, 1, 1);
+ * 
+ *      the ISR does y = PWL_getY(x, PWL_getActive(&myTable)), a task changes the table with PWL_beginUpdate() and PWL_commitUpdate() (or NTC_recalibratePWL())
+ *      storage holds both copies, so it must have space for twice the rows. Both start out with all points at 0
+ */
+Pwl_t * PWL_initDoubleBuffer(PwlDoubleBuffer_t * table, int32_t * storage, uint32_t rowCount, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    if(table == NULL || storage == NULL) return NULL;
+    
+    uint32_t bufferSize = PWL_STATIC_DATA_SIZE(PWL_TYPE_POINTS, preComputedDerivative, rowCount);
+    memset(storage, 0, 2 * bufferSize * sizeof(int32_t));
+    
+    PWL_init(&table->buffers[0], storage, rowCount, preComputedDerivative, preciceDerivative);
+    PWL_init(&table->buffers[1], storage + bufferSize, rowCount, preComputedDerivative, preciceDerivative);
+    table->active = &table->buffers[0];
+    
+    return table->active;
+}
+
+/*
+ * returns the copy of a double buffered PWL that isn't in use, with the rows of the active one copied into it
+ * 
+ * usage: change any points of the returned PWL (the rows have the format of PWL_getY()) and then call PWL_commitUpdate(). Lookups keep using the old table until then
+ * 
+ *      NOTE: only one task may update a table at a time. Lookups must be done from an interrupt or a task with a higher priority than the updating one, 
+ *            so no lookup can still be going on with a copy that was active two updates ago
+ */
+Pwl_t * PWL_beginUpdate(PwlDoubleBuffer_t * table){
+    if(table == NULL) return NULL;
+    
+    Pwl_t * active = table->active;
+    Pwl_t * shadow = (active == &table->buffers[0]) ? &table->buffers[1] : &table->buffers[0];
+    
+    //the header might have changed too (slopeShift, monotonicity), everything but the data pointer is copied
+    int32_t * data = shadow->data;
+    *shadow = *active;
+    shadow->data = data;
+    memcpy(shadow->data, active->data, PWL_getDataSize(active->listSizeRows, active->type, active->encoding, active->preComputedDerivative));
+    
+    return shadow;
+}
+
+/*
+ * finishes an update started with PWL_beginUpdate() and makes the new table the active one, lookups see either the complete old or the complete new one
+ * 
+ * only the derivatives of segments whose points changed are calculated again. If one of them doesn't fit the current slopeShift all of them are (see PWL_computeDerivatives())
+ * 
+ * returns 0 if a derivative doesn't fit the encoding at all, the table is swapped anyway
+ */
+uint32_t PWL_commitUpdate(PwlDoubleBuffer_t * table){
+    if(table == NULL) return 0;
+    
+    const Pwl_t * active = table->active;
+    Pwl_t * shadow = (active == &table->buffers[0]) ? &table->buffers[1] : &table->buffers[0];
+    
+    uint32_t ret = 1;
+    if(shadow->preComputedDerivative && shadow->listSizeRows >= 2){
+        int64_t limit = (shadow->encoding == PWL_ENCODING_INT16) ? INT16_MAX : INT32_MAX;
+        
+        //slopeShift 0 with preciceDerivative is the Q8 format (or the derivatives were never calculated), keep that decision to PWL_computeDerivatives()
+        uint32_t recomputeAll = shadow->preciceDerivative && shadow->slopeShift == 0;
+        
+        //a segment changed if either of its two points did
+        uint32_t lastChanged = 0;
+        for(uint32_t row = 0; row < shadow->listSizeRows && !recomputeAll; row++){
+            uint32_t changed = PWL_getPointX(shadow, row) != PWL_getPointX(active, row) || PWL_getPointY(shadow, row) != PWL_getPointY(active, row);
+            
+            if(row > 0 && (changed || lastChanged)){
+                //does the new slope still fit the shift all the others use?
+                if(shadow->preciceDerivative && PWL_getSegmentSlopeShift(shadow, row - 1, shadow->slopeShift, limit) < shadow->slopeShift){
+                    recomputeAll = 1;
+                }else if(!PWL_computeSegmentDerivative(shadow, row - 1, limit)){
+                    ret = 0;
+                }
+            }
+            lastChanged = changed;
+        }
+        
+        if(recomputeAll) ret = PWL_computeDerivatives(shadow);
+    }
+    
+    PWL_checkMonotonicity(shadow);
+    PWL_swapBuffers(table, shadow);
+    return ret;
+}
+
+//makes shadow the active copy. The store of the pointer is atomic, so a lookup always gets one complete table
+static void PWL_swapBuffers(PwlDoubleBuffer_t * table, Pwl_t * shadow){
+    __atomic_store_n(&table->active, shadow, __ATOMIC_RELEASE);
+}
+
+/* 
+ * Function to allocate a PWL with uniformly spaced points (PWL_TYPE_UNIFORM)
+ * 
+ * the x value of row i is x0 + (i << xStepShift), so the rows don't need to store it and the lookup doesn't need to search
+ * 
+ * PWL row-format:
+ *   preComputedDerivative=0:
+ *      {yValue}
+ *   preComputedDerivative=1:
+ *      {yValue,dY/dX}
+ * 
+ * note: 
+ *      if data=NULL will cause the function to try to allocate suitably sized memory for it aswell.
+ */
+Pwl_t * PWL_createUniform(int32_t * data, uint32_t rowCount, int32_t x0, uint32_t xStepShift, uint32_t preComputedDerivative, uint32_t preciceDerivative){
+    //a step of 2^31 or more can't be represented by the x values anyway
+    if(xStepShift > 30) return NULL;
+    
+    //create the header (and the data if needed) just like for a normal PWL, just with the smaller row size
+    Pwl_t * pwl = PWL_allocate(data, rowCount, PWL_TYPE_UNIFORM, PWL_ENCODING_INT32, preComputedDerivative, preciceDerivative);
+    if(pwl == NULL) return NULL;
+    
+    pwl->x0 = x0;
+    pwl->xStepShift = xStepShift;
+    
+    return pwl;
+}
+
+/* 
+ * Outputs a PWL as C source code, so a table generated at runtime (f.e. by NTC_generatePWL()) can be compiled into flash as a const table instead
+ * 
+ * usage: generate the table once, either host side or on the target, and print it with a printf compatible function. The output looks like this:
+ *      static const int32_t name_data[] = {
+ *          x0, y0, d0,
+ *          ...
+ *      };
+ *      static const Pwl_t name = PWL_STATIC_INIT(name_data, 1, 1);
+ * 
+ *      Paste that into a source file and pass &name to PWL_getY(), no generation or heap is needed at runtime anymore
+ */
+void PWL_print(const Pwl_t * pwl, const char * name, PWL_printFunction_t print){
+    if(pwl == NULL || name == NULL || print == NULL) return;
+    
+    uint32_t rowSize = PWL_getRowSize(pwl);
+    
+    print("static const %s %s_data[] = {\r\n", (pwl->encoding == PWL_ENCODING_INT16) ? "int16_t" : "int32_t", name);
+    
+    if(pwl->encoding == PWL_ENCODING_SOA){
+        //one column per line
+        for(uint32_t column = 0; column < rowSize; column++){
+            print("    ");
+            for(uint32_t row = 0; row < pwl->listSizeRows; row++) print("%ld, ", (long) PWL_getValue(pwl, row, column));
+            print("\r\n");
+        }
+    }else{
+        //one row per line, for readability
+        for(uint32_t row = 0; row < pwl->listSizeRows; row++){
+            print("    ");
+            for(uint32_t column = 0; column < rowSize; column++) print("%ld, ", (long) PWL_getValue(pwl, row, column));
+            print("\r\n");
+        }
+    }
+    
+    print("};\r\n");
+    
+    //and the header to go with it. Tables that can be inverted need the monotonicity in the header so PWL_getX() works with them and tables with a non default slopeShift need that too, that's only possible with PWL_STATIC_INIT_ENCODED()
+    if(pwl->encoding != PWL_ENCODING_INT32 || pwl->monotonicity != PWL_MONOTONIC_UNKNOWN || (pwl->preciceDerivative && PWL_getSlopeShift(pwl) != 8)){
+        const char * monotonicityNames[] = {"PWL_MONOTONIC_UNKNOWN", "PWL_MONOTONIC_NO", "PWL_MONOTONIC_RISING", "PWL_MONOTONIC_FALLING"};
+        const char * encodingNames[] = {"PWL_ENCODING_INT32", "PWL_ENCODING_INT16", "PWL_ENCODING_SOA"};
+        
+        print("static const Pwl_t %s = PWL_STATIC_INIT_ENCODED(%s_data, %s, %s, %ld, %lu, %lu, %lu, %lu, %s);\r\n", name, name, 
+                (pwl->type == PWL_TYPE_UNIFORM) ? "PWL_TYPE_UNIFORM" : "PWL_TYPE_POINTS", encodingNames[pwl->encoding], 
+                (long) pwl->x0, (unsigned long) pwl->xStepShift, (unsigned long) pwl->preComputedDerivative, (unsigned long) pwl->preciceDerivative, (unsigned long) pwl->slopeShift, monotonicityNames[pwl->monotonicity]);
+    }else if(pwl->type == PWL_TYPE_UNIFORM){
+        print("static const Pwl_t %s = PWL_STATIC_INIT_UNIFORM(%s_data, %ld, %lu, %lu, %lu);\r\n", name, name, (long) pwl->x0, (unsigned long) pwl->xStepShift, (unsigned long) pwl->preComputedDerivative, (unsigned long) pwl->preciceDerivative);
+    }else{
+        print("static const Pwl_t %s = PWL_STATIC_INIT(%s_data, %lu, %lu);\r\n", name, name, (unsigned long) pwl->preComputedDerivative, (unsigned long) pwl->preciceDerivative);
+    }
+}
+
+/* 
+ * Function to free a PWLs memory
+ * 
+ * freeData is only needed if the data was allocated separately by the caller and passed to PWL_create(), data allocated by PWL_create() is always freed
+ */
+void PWL_delete(Pwl_t * pwl, uint32_t freeData){
+    //is there anything to free?
+    if(pwl == NULL) return;
+    
+    //static PWLs (from PWL_init() or PWL_STATIC_INIT()) don't belong to the heap, nothing to do
+    if(pwl->storage == PWL_STORAGE_STATIC) return;
+    
+    //do we need to free the data? If yes then do so. If it was allocated together with the header it is freed with it anyway
+    if(freeData && pwl->storage == PWL_STORAGE_SEPARATE) UTIL_FREE(pwl->data);
+    
+    //free the header
+    UTIL_FREE(pwl);
+}
+
+
+
+
+
+
+
+
+/*
+ * two dimensional lookup table, bilinear interpolation of z in the grid cell around (x, y)
+ * 
+ * usage: create a grid with PWL2D_create() or PWL2D_init(), fill in the axes and the z values at every point, call PWL2D_computeDerivatives() and then convert with any x/y pair
+ *      Pwl2D_t * map = PWL2D_create(PWL_TYPE_POINTS, 5, PWL_TYPE_UNIFORM, 8, 1);
+ *      map->xAxis.points[0..4] = ...; map->yAxis.x0 = 0; map->yAxis.stepShift = 10;
+ *      PWL2D_getPoint(map, xi, yi)[0] = z;
+ *      PWL2D_computeDerivatives(map);
+ *      int32_t z = PWL2D_get(x, y, map);
+ *      
+ * preComputedDerivative tells the interpreter wether every grid point has the differences to its cell's other corners stored after its z value or not
+ * 
+ * grid point format (points are stored row by row, x changing fastest: point (xi, yi) is number yi * xAxis.pointCount + xi):
+ *   preComputedDerivative=0:
+ *      {z}
+ *   preComputedDerivative=1:
+ *      {z, dZx, dZy, dZxy}
+ *      - dZx:  z(xi+1, yi) - z
+ *      - dZy:  z(xi, yi+1) - z
+ *      - dZxy: z(xi+1, yi+1) - z(xi+1, yi) - z(xi, yi+1) + z
+ *      these are zero for the last point of each row and column
+ * 
+ * axes: each axis is either uniform (like a PWL of type PWL_TYPE_UNIFORM) or has a list of points, see Pwl2DAxis_t. 
+ *      The position inside the cell is calculated as a fraction with PWL2D_FRACTION_BITS bits, for a points axis this uses the inverse step so there is no division at all.
+ *      That fraction is exact to one LSB for steps of up to 65536
+ * 
+ *      NOTE: unlike PWL_getY() this doesn't extrapolate, outside of the grid the value at the nearest edge is returned. A bilinear surface diverges very quickly outside of its grid
+ *      NOTE: all products are calculated in 64 bits, z differences within the grid must fit into an int32_t though
+ */
+int32_t PWL2D_get(int32_t x, int32_t y, const Pwl2D_t * grid){
+    //check if we even got a grid, we need at least one cell
+    if(grid == NULL || grid->xAxis.pointCount < 2 || grid->yAxis.pointCount < 2) return 0;
+    
+    int32_t xFraction, yFraction;
+    uint32_t xSegment = PWL2D_findSegment(x, &grid->xAxis, UINT32_MAX, &xFraction);
+    uint32_t ySegment = PWL2D_findSegment(y, &grid->yAxis, UINT32_MAX, &yFraction);
+    
+    return PWL2D_interpolate(grid, xSegment, ySegment, xFraction, yFraction);
+}
+
+/*
+ * converts n x/y pairs at once, z[i] = PWL2D_get(x[i], y[i], grid)
+ * 
+ *      NOTE: the segments of the last pair are checked first before searching the axes again, so slowly changing inputs are converted without any search
+ *      NOTE: if the grid is invalid z is filled with zeros, just like PWL2D_get() would return
+ */
+void PWL2D_getBatch(const int32_t * x, const int32_t * y, int32_t * z, size_t n, const Pwl2D_t * grid){
+    if(grid == NULL || grid->xAxis.pointCount < 2 || grid->yAxis.pointCount < 2){
+        for(size_t i = 0; i < n; i++) z[i] = 0;
+        return;
+    }
+    
+    uint32_t xSegment = 0;
+    uint32_t ySegment = 0;
+    int32_t xFraction, yFraction;
+    
+    for(size_t i = 0; i < n; i++){
+        xSegment = PWL2D_findSegment(x[i], &grid->xAxis, xSegment, &xFraction);
+        ySegment = PWL2D_findSegment(y[i], &grid->yAxis, ySegment, &yFraction);
+        z[i] = PWL2D_interpolate(grid, xSegment, ySegment, xFraction, yFraction);
+    }
+}
+
+/*
+ * returns the segment of the axis that contains x and writes the position of x inside of it to fraction (0 to 1 << PWL2D_FRACTION_BITS)
+ * 
+ * hint is the segment to check first before searching, UINT32_MAX if there is none. x outside of the axis is clamped to its first or last point
+ */
+static inline uint32_t PWL2D_findSegment(int32_t x, const Pwl2DAxis_t * axis, uint32_t hint, int32_t * fraction){
+    uint32_t lastSegment = axis->pointCount - 2;
+    
+    if(axis->type == PWL_TYPE_UNIFORM){
+        //same as PWL_getYUniform(), the segment is just the offset from x0 divided by the step
+        int64_t localX = (int64_t) x - axis->x0;
+        if(localX <= 0){
+            *fraction = 0;
+            return 0;
+        }
+        
+        uint64_t segment = (uint64_t) localX >> axis->stepShift;
+        if(segment > lastSegment){
+            *fraction = 1 << PWL2D_FRACTION_BITS;
+            return lastSegment;
+        }
+        
+        //scale the offset in the segment to the fraction format
+        localX -= (int64_t) segment << axis->stepShift;
+        if(axis->stepShift <= PWL2D_FRACTION_BITS){
+            *fraction = (int32_t) (localX << (PWL2D_FRACTION_BITS - axis->stepShift));
+        }else{
+            *fraction = (int32_t) (localX >> (axis->stepShift - PWL2D_FRACTION_BITS));
+        }
+        
+        return (uint32_t) segment;
+    }
+    
+    const int32_t * points = axis->points;
+    
+    //clamp x to the axis
+    if(x <= points[0]){
+        *fraction = 0;
+        return 0;
+    }
+    if(x >= points[lastSegment + 1]){
+        *fraction = 1 << PWL2D_FRACTION_BITS;
+        return lastSegment;
+    }
+    
+    //is x still inside of the hinted segment? If not do a binary search for it
+    uint32_t segment = hint;
+    if(segment > lastSegment || x < points[segment] || x >= points[segment + 1]){
+        //first point that is not smaller than x. x is inside the axis so that point is never the first one
+        segment = PWL_searchInt32(x, points, 1, axis->pointCount, 0);
+        if(points[segment] != x) segment--;
+    }
+    
+    //fraction = (x - start) / step, with the precomputed 2^31 / step
+    uint32_t localX = (uint32_t) (x - points[segment]);
+    uint32_t scaled = (uint32_t) (((uint64_t) localX * axis->inverseStep[segment]) >> (31 - PWL2D_FRACTION_BITS));
+    *fraction = (scaled > (1 << PWL2D_FRACTION_BITS)) ? (1 << PWL2D_FRACTION_BITS) : (int32_t) scaled;
+    
+    return segment;
+}
+
+/*
+ * bilinear interpolation inside of the cell starting at grid point (xSegment, ySegment)
+ */
+static inline int32_t PWL2D_interpolate(const Pwl2D_t * grid, uint32_t xSegment, uint32_t ySegment, int32_t xFraction, int32_t yFraction){
+    const int32_t * point = PWL2D_getPoint(grid, xSegment, ySegment);
+    int32_t dZx, dZy, dZxy;
+    
+    if(grid->preComputedDerivative){
+        //nothing to compute, just read the differences from the point
+        dZx = point[1];
+        dZy = point[2];
+        dZxy = point[3];
+    }else{
+        const int32_t * nextRow = point + grid->xAxis.pointCount;
+        dZx = point[1] - point[0];
+        dZy = nextRow[0] - point[0];
+        dZxy = nextRow[1] - nextRow[0] - dZx;
+    }
+    
+    //z = z00 + dZx * fx + dZy * fy + dZxy * fx * fy
+    int64_t sum = (int64_t) dZx * xFraction + (int64_t) dZy * yFraction + (int64_t) dZxy * (((int64_t) xFraction * yFraction) >> PWL2D_FRACTION_BITS);
+    
+    //round to the nearest value
+    return point[0] + (int32_t) ((sum + (1 << (PWL2D_FRACTION_BITS - 1))) >> PWL2D_FRACTION_BITS);
+}
+
+/*
+ * calculates the inverse steps of the points axes and (with preComputedDerivative) the differences stored at every grid point
+ * 
+ * call this after the axes and z values were filled in or changed
+ * 
+ * returns 0 if an axis has less than two points or isn't sorted in strictly ascending order
+ */
+uint32_t PWL2D_computeDerivatives(Pwl2D_t * grid){
+    if(grid == NULL) return 0;
+    
+    //precompute the inverse steps of the points axes
+    Pwl2DAxis_t * axes[] = {&grid->xAxis, &grid->yAxis};
+    for(uint32_t i = 0; i < 2; i++){
+        Pwl2DAxis_t * axis = axes[i];
+        if(axis->pointCount < 2) return 0;
+        if(axis->type == PWL_TYPE_UNIFORM) continue;
+        
+        for(uint32_t segment = 0; segment < axis->pointCount - 1; segment++){
+            int64_t step = (int64_t) axis->points[segment + 1] - axis->points[segment];
+            if(step <= 0) return 0;
+            
+            //rounded to the nearest value, step >= 1 so this always fits
+            axis->inverseStep[segment] = (uint32_t) ((((uint64_t) 1 << 31) + (uint64_t) step / 2) / (uint64_t) step);
+        }
+        
+        //the last point doesn't start a segment
+        axis->inverseStep[axis->pointCount - 1] = 0;
+    }
+    
+    if(!grid->preComputedDerivative) return 1;
+    
+    //calculate the differences of each cell and store them at its first point
+    uint32_t xCount = grid->xAxis.pointCount;
+    uint32_t yCount = grid->yAxis.pointCount;
+    for(uint32_t yi = 0; yi < yCount; yi++){
+        for(uint32_t xi = 0; xi < xCount; xi++){
+            int32_t * point = PWL2D_getPoint(grid, xi, yi);
+            int32_t right = (xi + 1 < xCount) ? PWL2D_getPoint(grid, xi + 1, yi)[0] : point[0];
+            int32_t above = (yi + 1 < yCount) ? PWL2D_getPoint(grid, xi, yi + 1)[0] : point[0];
+            int32_t diagonal = (xi + 1 < xCount && yi + 1 < yCount) ? PWL2D_getPoint(grid, xi + 1, yi + 1)[0] : right + above - point[0];
+            
+            point[1] = right - point[0];
+            point[2] = above - point[0];
+            point[3] = diagonal - right - above + point[0];
+        }
+    }
+    
+    return 1;
+}
+
+/* 
+ * Function to create a new grid with xCount * yCount points
+ * 
+ * header, axes and grid points are allocated in a single block. Uniform axes start with x0=0 and a stepShift of 0, set them and the points of points axes together with the z values,
+ * then call PWL2D_computeDerivatives()
+ * 
+ *      NOTE: If you don't want to use the heap at all use PWL2D_init() instead
+ */
+Pwl2D_t * PWL2D_create(PwlType_t xType, uint32_t xCount, PwlType_t yType, uint32_t yCount, uint32_t preComputedDerivative){
+    uint32_t dataSize = PWL2D_STATIC_DATA_SIZE(xType, xCount, yType, yCount, preComputedDerivative) * sizeof(int32_t);
+    
+    Pwl2D_t * grid = utilAllocate(sizeof(Pwl2D_t) + dataSize);
+    if(grid == NULL) return NULL;
+    
+    //the data starts right after the header, sizeof(Pwl2D_t) is a multiple of 4 just like sizeof(Pwl_t)
+    PWL2D_init(grid, (int32_t *) (void *) (grid + 1), xType, xCount, yType, yCount, preComputedDerivative);
+    grid->storage = PWL_STORAGE_CONTIGUOUS;
+    
+    return grid;
+}
+
+/* 
+ * Function to initialise a grid in memory owned by the caller, the heap is never touched
+ * 
+ * usage: 
+ *      Pwl2D_t myGrid;
+ *      int32_t myGridData[PWL2D_STATIC_DATA_SIZE(PWL_TYPE_POINTS, X_COUNT, PWL_TYPE_UNIFORM, Y_COUNT, 1)];
+ *      PWL2D_init(&myGrid, myGridData, PWL_TYPE_POINTS, X_COUNT, PWL_TYPE_UNIFORM, Y_COUNT, 1);
+ * 
+ *      storage is split into the points and inverse steps of each points axis and the grid points after that
+ *      
+ *      NOTE: a grid created with this must not be passed to PWL2D_delete() (it will just be ignored if you do)
+ */
+Pwl2D_t * PWL2D_init(Pwl2D_t * grid, int32_t * storage, PwlType_t xType, uint32_t xCount, PwlType_t yType, uint32_t yCount, uint32_t preComputedDerivative){
+    if(grid == NULL || storage == NULL) return NULL;
+    
+    Pwl2DAxis_t * axes[] = {&grid->xAxis, &grid->yAxis};
+    PwlType_t types[] = {xType, yType};
+    uint32_t counts[] = {xCount, yCount};
+    
+    for(uint32_t i = 0; i < 2; i++){
+        Pwl2DAxis_t * axis = axes[i];
+        axis->pointCount = counts[i];
+        axis->type = types[i];
+        axis->x0 = 0;
+        axis->stepShift = 0;
+        axis->points = NULL;
+        axis->inverseStep = NULL;
+        
+        //uniform axes don't need any memory
+        if(types[i] == PWL_TYPE_POINTS){
+            axis->points = storage;
+            axis->inverseStep = (uint32_t *) (void *) (storage + counts[i]);
+            storage += 2 * counts[i];
+        }
+    }
+    
+    grid->data = storage;
+    grid->preComputedDerivative = preComputedDerivative;
+    grid->storage = PWL_STORAGE_STATIC;
+    
+    return grid;
+}
+
+/* 
+ * Function to free a grids memory
+ */
+void PWL2D_delete(Pwl2D_t * grid){
+    //static grids (from PWL2D_init() or PWL2D_STATIC_INIT()) don't belong to the heap, nothing to do
+    if(grid == NULL || grid->storage == PWL_STORAGE_STATIC) return;
+    
+    //axes and grid points are in the same block as the header
+    UTIL_FREE(grid);
+}
+
+/*
+ * outputs the grid as C source code for a const grid, same idea as PWL_print()
+ * 
+ * the output contains name_data with one row of grid points per line, name_x/name_xInverse and name_y/name_yInverse for points axes and the PWL2D_STATIC_INIT() header
+ *
+ *      NOTE: call PWL2D_computeDerivatives() before printing, the inverse steps are printed as they are
+ */
+void PWL2D_print(const Pwl2D_t * grid, const char * name, PWL_printFunction_t print){
+    if(grid == NULL || name == NULL || print == NULL) return;
+    
+    uint32_t pointSize = PWL2D_getPointSize(grid);
+    
+    print("static const int32_t %s_data[] = {\r\n", name);
+    for(uint32_t yi = 0; yi < grid->yAxis.pointCount; yi++){
+        print("    ");
+        for(uint32_t xi = 0; xi < grid->xAxis.pointCount; xi++){
+            const int32_t * point = PWL2D_getPoint(grid, xi, yi);
+            for(uint32_t i = 0; i < pointSize; i++) print("%ld, ", (long) point[i]);
+        }
+        print("\r\n");
+    }
+    print("};\r\n");
+    
+    //the points and inverse steps of both axes, if they have any
+    const Pwl2DAxis_t * axes[] = {&grid->xAxis, &grid->yAxis};
+    const char * axisNames[] = {"x", "y"};
+    for(uint32_t i = 0; i < 2; i++){
+        if(axes[i]->type == PWL_TYPE_UNIFORM) continue;
+        
+        print("static const int32_t %s_%s[] = {", name, axisNames[i]);
+        for(uint32_t point = 0; point < axes[i]->pointCount; point++) print("%ld, ", (long) axes[i]->points[point]);
+        print("};\r\n");
+        
+        print("static const uint32_t %s_%sInverse[] = {", name, axisNames[i]);
+        for(uint32_t point = 0; point < axes[i]->pointCount; point++) print("%lu, ", (unsigned long) axes[i]->inverseStep[point]);
+        print("};\r\n");
+    }
+    
+    //and the header to go with it
+    print("static const Pwl2D_t %s = PWL2D_STATIC_INIT(%s_data, ", name, name);
+    for(uint32_t i = 0; i < 2; i++){
+        if(axes[i]->type == PWL_TYPE_UNIFORM){
+            print("PWL2D_STATIC_AXIS_UNIFORM(%lu, %ld, %lu), ", (unsigned long) axes[i]->pointCount, (long) axes[i]->x0, (unsigned long) axes[i]->stepShift);
+        }else{
+            print("PWL2D_STATIC_AXIS_POINTS(%s_%s, %s_%sInverse), ", name, axisNames[i], name, axisNames[i]);
+        }
+    }
+    print("%lu);\r\n", (unsigned long) grid->preComputedDerivative);
+}
+
+
+
+
+
+
+
+
+/*
+ * NTC Tool - generates a PWL with a specified number of rows that allows for faster conversion of resistance to temperature
+ *      TODO: not sure if we actually need this, but it might be useful: NOTE: for conversion of divider ratio to resistance check NTC_calculateNTCResistance()
+ * 
+ * usage: 
+ *      specify NTC parameters with ntcBaseResistance (f.e. 10k) and the coefficients (available in the datasheet, sometimes called A,B & C instead of a0,a1 & a2)
+ *      For Steinhart-Hart coefficients set model to NTC_MODEL_STEINHART_HART and fill in A, B and C instead of R0, T0 and Beta
+ *      List size is determined by the start & endTemperature (I recommend only specifying the temperature region of interest to you here to increase accuracy) and the point Count. Use at least (TODO: figure out how many points are recommended lol)
+ *      select the unit of the PWL with the 
+ * 
+ *      To perform the conversion pass the generated PWL to the PWL_getY() function together with the resistance in Ohms. preComputedDerivative must be set to 1
+ * 
+ *      NOTE: if the NTC parameters are fixed, generate the table once and use PWL_print() to turn it into a const table in flash instead
+ */
+Pwl_t * NTC_generatePWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t pointCount, NTC_TemperatureUnit_t unit){
+//are the parameters valid?
+    if(startTemperature >= endTemperature || pointCount < 2 || coefficients == NULL) return NULL;
+    
+//create a new PWL. Just return if that doesn't work
+    Pwl_t * pwl = PWL_create(NULL, pointCount, 1, 1);
+    if(pwl == NULL) return NULL;
+    
+    NTC_fillPWL(pwl, coefficients, startTemperature, endTemperature, unit);
+    
+    return pwl;
+}
+
+/*
+ * NTC Tool - fills an existing PWL with the same table NTC_generatePWL() would create, f.e. one from PWL_init() with caller owned storage
+ * 
+ * the PWL must be of type PWL_TYPE_POINTS and PWL_ENCODING_INT32 with preComputedDerivative=1 and preciceDerivative=1, its listSizeRows is used as the point count
+ * 
+ * returns 0 if the parameters were invalid (the PWL is left untouched then), 1 otherwise
+ */
+uint32_t NTC_fillPWL(Pwl_t * pwl, NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, NTC_TemperatureUnit_t unit){
+//are the parameters valid?
+    if(pwl == NULL || coefficients == NULL || startTemperature >= endTemperature || pwl->listSizeRows < 2) return 0;
+    if(pwl->type != PWL_TYPE_POINTS || pwl->encoding != PWL_ENCODING_INT32 || !pwl->preComputedDerivative || !pwl->preciceDerivative) return 0;
+    
+    uint32_t pointCount = pwl->listSizeRows;
+    
+//calculate start and end resistance values. The end value is the one matching the start temperature as we need to sort by ascending resistance
+    
+    float startResistance = NTC_getResistanceAtTemperature(coefficients, endTemperature, unit);
+    float endResistance = NTC_getResistanceAtTemperature(coefficients, startTemperature, unit);
+    float resistanceStep = ((float) endResistance - (float) startResistance) / (float) pointCount;
+    
+    //step through each list entry and calculate the temperature corresponding to the resistance
+    //for reference: PWL format with preComputedDerivative=1 is {xValue,yValue,dY/dX}
+    
+    float currentResistance = startResistance;
+    
+    for(uint32_t i = 0; i < pointCount; i++){
+        //generate a pointer to the current row
+        int32_t * currentRow = &(pwl->data[i * 3]);
+        
+        //first row entry is the x value (in our case the resistance)
+        currentRow[0] = (int32_t) currentResistance;
+        
+        //second row entry is the resulting y value (aka the temperature, converted into the desired unit)
+        currentRow[1] = NTC_getTemperatureAtResistance(coefficients, currentResistance, unit);
+        
+        currentResistance += resistanceStep;
+    }
+    
+    //third row entry is the derivative between each point and the next one, now that we have all points we can calculate them with the best suited precision
+    PWL_computeDerivatives(pwl);
+    PWL_checkMonotonicity(pwl);
+    
+    return 1;
+}
+
+/*
+ * NTC Tool - same as NTC_fillPWL() but for a double buffered PWL (see PWL_initDoubleBuffer()), f.e. to apply a new calibration while the ISR keeps converting
+ * 
+ * usage: the new table is generated into the copy that isn't in use and swapped in once it is complete, nothing is allocated. 
+ *      The PWL must have been initialised with preComputedDerivative and preciceDerivative set, just like for NTC_fillPWL()
+ * 
+ * returns 0 if the parameters are invalid, the old table stays active then
+ */
+uint32_t NTC_recalibratePWL(PwlDoubleBuffer_t * table, NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, NTC_TemperatureUnit_t unit){
+    Pwl_t * shadow = PWL_beginUpdate(table);
+    if(shadow == NULL) return 0;
+    
+    //every point moves with new coefficients, so NTC_fillPWL() calculates all derivatives anyway and PWL_commitUpdate() isn't needed
+    if(!NTC_fillPWL(shadow, coefficients, startTemperature, endTemperature, unit)) return 0;
+    
+    PWL_swapBuffers(table, shadow);
+    return 1;
+}
+
+/*
+ * NTC Tool - same as NTC_generatePWL() but generates a PWL_TYPE_UNIFORM table, which needs no search and no x values in its rows
+ * 
+ * usage: 
+ *      the resistance step is the smallest power of two that covers the resistance range of start- to endTemperature with at most maxPointCount points.
+ *      The actual number of rows is stored in listSizeRows of the PWL.
+ * 
+ *      To perform the conversion pass the generated PWL to the PWL_getY() function together with the resistance in Ohms
+ *      This can be turned into a const table with PWL_print() just like the one from NTC_generatePWL()
+ */
+Pwl_t * NTC_generateUniformPWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, NTC_TemperatureUnit_t unit){
+//are the parameters valid?
+    if(startTemperature >= endTemperature || maxPointCount < 2 || coefficients == NULL) return NULL;
+    
+//calculate the resistance range. The end value is the one matching the start temperature as we need to sort by ascending resistance
+    int32_t startResistance = (int32_t) NTC_getResistanceAtTemperature(coefficients, endTemperature, unit);
+    int32_t endResistance = (int32_t) NTC_getResistanceAtTemperature(coefficients, startTemperature, unit) + 1;
+    if(startResistance < 0 || endResistance <= startResistance) return NULL;
+    
+//find the smallest step that fits the range into the maximum number of points (the last point may be past endResistance)
+    uint32_t span = endResistance - startResistance;
+    uint32_t stepShift = 0;
+    while(((span + (1 << stepShift) - 1) >> stepShift) + 1 > maxPointCount) stepShift++;
+    
+    uint32_t pointCount = ((span + (1 << stepShift) - 1) >> stepShift) + 1;
+    
+//create a new PWL. Just return if that doesn't work
+    Pwl_t * pwl = PWL_createUniform(NULL, pointCount, startResistance, stepShift, 1, 1);
+    if(pwl == NULL) return NULL;
+    
+    //step through each list entry and calculate the temperature corresponding to the resistance
+    //for reference: PWL format with preComputedDerivative=1 is {yValue,dY/dX}
+    for(uint32_t i = 0; i < pointCount; i++){
+        //first row entry is the temperature at the resistance of the row, converted into the desired unit
+        pwl->data[i * 2] = NTC_getTemperatureAtResistance(coefficients, (float) (startResistance + (int32_t) (i << stepShift)), unit);
+    }
+    
+    //second row entry is the derivative between this point and the next one
+    PWL_computeDerivatives(pwl);
+    PWL_checkMonotonicity(pwl);
+    
+    return pwl;
+}
+
+/*
+ * NTC Tool - generates a PWL_TYPE_UNIFORM table that converts the raw ADC count of an NTC voltage divider directly into a temperature
+ * 
+ * usage: 
+ *      describe the divider with an NTC_Divider_t, the ADC count range is calculated from start- to endTemperature and split into the smallest power of two step 
+ *      that needs at most maxPointCount points (same as NTC_generateUniformPWL())
+ *      
+ *      NTC_Divider_t divider = {.topology = NTC_DIVIDER_NTC_TO_GROUND, .fixedResistance = 10000, .adcBits = 12};
+ *      Pwl_t * table = NTC_generateAdcPWL(&coefficients, &divider, -20000, 120000, 64, NTC_MILLI_DEG_CELSIUS);
+ *      int32_t temperature = PWL_getY(adcCount, table);
+ * 
+ *      The division from the count to the resistance is folded into the table, so a conversion is just the uniform lookup
+ *      Use NTC_printAdcPWL() to turn the table into a const one for fixed hardware
+ *      
+ *      NOTE: the count c is assumed to be c / 2^adcBits of the reference voltage. Counts 0 and 2^adcBits - 1 and above are never in the table, the NTC resistance would be 0 or infinite there.
+ *            The same goes for counts at which the divider ratio reaches 1 when the divider supply is above the reference voltage. 
+ *            The table is moved down so it ends at the end of the temperature range if that is needed to stay inside of the valid counts, 
+ *            if it doesn't fit at all the value of the last point is extrapolated from the last valid count
+ */
+Pwl_t * NTC_generateAdcPWL(NTC_Coefficients_t * coefficients, const NTC_Divider_t * divider, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, NTC_TemperatureUnit_t unit){
+//are the parameters valid?
+    if(startTemperature >= endTemperature || maxPointCount < 2 || coefficients == NULL || divider == NULL) return NULL;
+    if(divider->adcBits < 2 || divider->adcBits > 24 || divider->fixedResistance <= 0) return NULL;
+    
+    int32_t fullScale = 1 << divider->adcBits;
+    
+//calculate the count range. Depending on the topology the count either rises or falls with temperature, so just sort the two
+    float startCountF = NTC_getAdcCountAtResistance(divider, NTC_getResistanceAtTemperature(coefficients, startTemperature, unit));
+    float endCountF = NTC_getAdcCountAtResistance(divider, NTC_getResistanceAtTemperature(coefficients, endTemperature, unit));
+    if(startCountF > endCountF){
+        float temp = startCountF;
+        startCountF = endCountF;
+        endCountF = temp;
+    }
+    
+    //last count that still has a resistance. If the divider supply is above the ADC reference the ratio reaches 1 before the end of the ADC range
+    float lastCountF = (float) fullScale / NTC_getDividerScale(divider);
+    int32_t lastValidCount = (lastCountF < (float) (fullScale - 2)) ? (int32_t) lastCountF : fullScale - 2;
+    while(lastValidCount > 1 && NTC_getResistanceAtAdcCount(divider, (float) lastValidCount) <= 0) lastValidCount--;
+    
+    //stay away from the ends of the ADC range. A temperature range that is completely outside of it doesn't work at all
+    int32_t startCount = (startCountF < 1) ? 1 : (int32_t) startCountF;
+    int32_t endCount = (endCountF >= (float) lastValidCount) ? lastValidCount : (int32_t) endCountF + 1;
+    if(endCount <= startCount) return NULL;
+    
+//find the smallest step that fits the range into the maximum number of points (the last point may be past endCount)
+    uint32_t span = endCount - startCount;
+    uint32_t stepShift = 0;
+    while(((span + (1 << stepShift) - 1) >> stepShift) + 1 > maxPointCount) stepShift++;
+    
+    uint32_t pointCount = ((span + (1 << stepShift) - 1) >> stepShift) + 1;
+    
+    //if the last point would be past the last valid count let the table end at endCount instead, as long as there is room for that below startCount
+    int32_t tableSpan = (int32_t) ((pointCount - 1) << stepShift);
+    if(startCount + tableSpan > lastValidCount && endCount - tableSpan >= 1) startCount = endCount - tableSpan;
+    
+//create a new PWL. Just return if that doesn't work
+    Pwl_t * pwl = PWL_createUniform(NULL, pointCount, startCount, stepShift, 1, 1);
+    if(pwl == NULL) return NULL;
+    
+    //step through each list entry and calculate the temperature at the count of the row
+    for(uint32_t i = 0; i < pointCount; i++){
+        int32_t count = startCount + (int32_t) (i << stepShift);
+        
+        if(count > lastValidCount){
+            //only the last point can still be past the last valid count (if the table didn't fit below it), the one before it is below endCount. 
+            //Extend the line from the previous point to the last valid count up to it, so the last segment is still exact at both of them
+            int32_t previousCount = count - (1 << stepShift);
+            int64_t previousY = pwl->data[(i - 1) * 2];
+            int64_t lastY = NTC_getTemperatureAtResistance(coefficients, NTC_getResistanceAtAdcCount(divider, (float) lastValidCount), unit);
+            pwl->data[i * 2] = (int32_t) (previousY + (lastY - previousY) * (1 << stepShift) / (lastValidCount - previousCount));
+            continue;
+        }
+        
+        pwl->data[i * 2] = NTC_getTemperatureAtResistance(coefficients, NTC_getResistanceAtAdcCount(divider, (float) count), unit);
+    }
+    
+    PWL_computeDerivatives(pwl);
+    PWL_checkMonotonicity(pwl);
+    
+    return pwl;
+}
+
+/*
+ * generates the table of NTC_generateAdcPWL() and prints it as a const table with PWL_print(), so boards with fixed hardware don't need to generate it at runtime
+ * 
+ * returns 0 if the table couldn't be generated
+ */
+uint32_t NTC_printAdcPWL(NTC_Coefficients_t * coefficients, const NTC_Divider_t * divider, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, NTC_TemperatureUnit_t unit, const char * name, PWL_printFunction_t print){
+    Pwl_t * pwl = NTC_generateAdcPWL(coefficients, divider, startTemperature, endTemperature, maxPointCount, unit);
+    if(pwl == NULL) return 0;
+    
+    PWL_print(pwl, name, print);
+    PWL_delete(pwl, 0);
+    
+    return 1;
+}
+
+//fraction of the ADC reference per fraction of the divider supply
+static float NTC_getDividerScale(const NTC_Divider_t * divider){
+    //0 means the divider runs off the ADC reference
+    if(divider->supplyVoltage <= 0 || divider->referenceVoltage <= 0) return 1.0;
+    return divider->referenceVoltage / divider->supplyVoltage;
+}
+
+/*
+ * resistance of the NTC at a given ADC count, returns a negative value if there is no valid resistance for it
+ */
+static float NTC_getResistanceAtAdcCount(const NTC_Divider_t * divider, float count){
+    //divider ratio = lower resistor / (upper resistor + lower resistor)
+    float ratio = count / (float) (1 << divider->adcBits) * NTC_getDividerScale(divider);
+    if(ratio <= 0 || ratio >= 1) return -1;
+    
+    if(divider->topology == NTC_DIVIDER_NTC_TO_GROUND){
+        //NTC is the lower resistor
+        return divider->fixedResistance * ratio / (1 - ratio);
+    }else{
+        //NTC is the upper resistor
+        return divider->fixedResistance * (1 - ratio) / ratio;
+    }
+}
+
+//ADC count at a given NTC resistance, the inverse of NTC_getResistanceAtAdcCount()
+static float NTC_getAdcCountAtResistance(const NTC_Divider_t * divider, float resistance){
+    float ratio;
+    
+    if(divider->topology == NTC_DIVIDER_NTC_TO_GROUND){
+        ratio = resistance / (divider->fixedResistance + resistance);
+    }else{
+        ratio = divider->fixedResistance / (divider->fixedResistance + resistance);
+    }
+    
+    return ratio / NTC_getDividerScale(divider) * (float) (1 << divider->adcBits);
+}
+
+/*
+ * NTC acquisition - initialises the state of one channel of NTC_processBlock()
+ * 
+ * usage: 
+ *      table converts the averaged ADC count to a temperature, usually one from NTC_generateAdcPWL() (or its const version from NTC_printAdcPWL())
+ *      2^oversamplingShift samples are averaged for every conversion
+ *      filterShift sets the IIR filter of the temperature: filtered += (temperature - filtered) / 2^filterShift, 0 turns the filter off
+ * 
+ *      NOTE: oversamplingShift is clamped to NTC_MAX_OVERSAMPLING_SHIFT and filterShift to NTC_MAX_FILTER_SHIFT
+ *      NOTE: the table isn't copied, it must stay valid as long as the channel is used
+ */
+void NTC_initChannel(NTC_Channel_t * channel, const Pwl_t * table, uint32_t oversamplingShift, uint32_t filterShift){
+    if(channel == NULL) return;
+    
+    channel->table = table;
+    
+    //larger shifts would overflow the accumulator or be undefined in NTC_processBlock()
+    channel->oversamplingShift = (oversamplingShift > NTC_MAX_OVERSAMPLING_SHIFT) ? NTC_MAX_OVERSAMPLING_SHIFT : oversamplingShift;
+    channel->filterShift = (filterShift > NTC_MAX_FILTER_SHIFT) ? NTC_MAX_FILTER_SHIFT : filterShift;
+    channel->accumulator = 0;
+    channel->sampleCount = 0;
+    channel->cursor.segment = 0;
+    channel->filterState = 0;
+    channel->temperature = 0;
+    channel->conversionCount = 0;
+}
+
+/*
+ * NTC acquisition - processes a block of interleaved samples for all channels at once
+ * 
+ * usage: 
+ *      samples is the ADC (DMA) buffer with one sample of every channel after another: {ch0, ch1, ..., chN-1, ch0, ch1, ...}, samplesPerChannel of those frames
+ *      For every channel the samples are accumulated until 2^oversamplingShift are there, then their average is converted with a cursor lookup into the table 
+ *      and the result is filtered into channel->temperature. channel->conversionCount counts the conversions so the reader can see whether there is a new value
+ * 
+ *      returns the number of conversions done in this block (of all channels)
+ * 
+ *      NOTE: an average can span several blocks, the accumulator is part of the channel state
+ *      NOTE: the buffer is read in order, one frame after the other, and the state of all channels is small enough to stay in the cache the whole time
+ */
+uint32_t NTC_processBlock(NTC_Channel_t * channels, uint32_t channelCount, const uint16_t * samples, uint32_t samplesPerChannel){
+    if(channels == NULL || samples == NULL) return 0;
+    
+    uint32_t conversions = 0;
+    
+    for(uint32_t frame = 0; frame < samplesPerChannel; frame++){
+        const uint16_t * frameSamples = &samples[frame * channelCount];
+        
+        for(uint32_t i = 0; i < channelCount; i++){
+            NTC_Channel_t * channel = &channels[i];
+            
+            channel->accumulator += frameSamples[i];
+            if(++channel->sampleCount < (1U << channel->oversamplingShift)) continue;
+            
+            //got enough samples, average them. Rounded instead of truncated so the average isn't half a count low
+            uint32_t rounding = (1U << channel->oversamplingShift) >> 1;
+            int32_t average = (int32_t) ((channel->accumulator + rounding) >> channel->oversamplingShift);
+            channel->accumulator = 0;
+            channel->sampleCount = 0;
+            
+            //neighbouring conversions are close to each other, so the cursor almost never needs to search
+            int32_t temperature = PWL_getYCursor(average, channel->table, &channel->cursor);
+            
+            //first conversion starts the filter at the current value instead of letting it creep up from 0
+            int32_t scaledTemperature = temperature * (1 << NTC_FILTER_FRACTION_BITS);
+            if(channel->conversionCount == 0 || channel->filterShift == 0){
+                channel->filterState = scaledTemperature;
+            }else{
+                channel->filterState += (scaledTemperature - channel->filterState) >> channel->filterShift;
+            }
+            
+            channel->temperature = channel->filterState >> NTC_FILTER_FRACTION_BITS;
+            channel->conversionCount++;
+            conversions++;
+        }
+    }
+    
+    return conversions;
+}
+
+/*
+ * NTC Tool - same as NTC_generatePWL() but places the points where the curve needs them, instead of spacing them evenly in resistance
+ * 
+ * usage: 
+ *      starts with a single segment from start- to endTemperature and then keeps splitting the segment with the largest interpolation error at the point where that error occurs.
+ *      Stops once maxPointCount points are used or the error of every segment is no larger than maxError (in the unit of the PWL). Set maxError to 0 to always use all points.
+ *      
+ *      if achievedError isn't NULL the largest error of the generated PWL is written to it (in the unit of the PWL). 
+ *      This is the error of the actual lookup (including the rounding of the pre computed derivative), sampled at NTC_ADAPTIVE_SAMPLES points per segment
+ * 
+ *      To perform the conversion pass the generated PWL to the PWL_getY() function together with the resistance in Ohms
+ * 
+ *      NOTE: this needs two temporary buffers of maxPointCount int32_t's while generating the PWL
+ */
+Pwl_t * NTC_generateAdaptivePWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t maxPointCount, int32_t maxError, NTC_TemperatureUnit_t unit, int32_t * achievedError){
+//are the parameters valid?
+    if(startTemperature >= endTemperature || maxPointCount < 2 || coefficients == NULL) return NULL;
+    
+//calculate the resistance range. The end value is the one matching the start temperature as we need to sort by ascending resistance
+    int32_t startResistance = (int32_t) NTC_getResistanceAtTemperature(coefficients, endTemperature, unit);
+    int32_t endResistance = (int32_t) NTC_getResistanceAtTemperature(coefficients, startTemperature, unit);
+    if(startResistance < 1 || endResistance <= startResistance) return NULL;
+    
+//allocate the buffers for the point positions and the error of the segment starting at each point
+    int32_t * points = utilAllocate(sizeof(int32_t) * maxPointCount);
+    int32_t * errors = utilAllocate(sizeof(int32_t) * maxPointCount);
+    if(points == NULL || errors == NULL){
+        UTIL_FREE(points);
+        UTIL_FREE(errors);
+        return NULL;
+    }
+    
+    //and start off with just the end points
+    uint32_t pointCount = 2;
+    points[0] = startResistance;
+    points[1] = endResistance;
+    errors[0] = NTC_getSegmentError(coefficients, points[0], points[1], unit, NULL);
+    
+    //now keep splitting the worst segment until we run out of points or the error is small enough
+    while(pointCount < maxPointCount){
+        //find the segment with the largest error
+        uint32_t worstSegment = 0;
+        for(uint32_t i = 1; i < pointCount - 1; i++){
+            if(errors[i] > errors[worstSegment]) worstSegment = i;
+        }
+        
+        //is it good enough already? Or can't it be split anymore? (that can only happen if all segments are only one ohm wide)
+        if(errors[worstSegment] <= maxError || points[worstSegment + 1] - points[worstSegment] < 2) break;
+        
+        //find out where the error is largest again, that is where the new point goes
+        int32_t splitPoint = 0;
+        NTC_getSegmentError(coefficients, points[worstSegment], points[worstSegment + 1], unit, &splitPoint);
+        
+        //make space for the new point
+        for(uint32_t i = pointCount; i > worstSegment + 1; i--){
+            points[i] = points[i - 1];
+            errors[i] = errors[i - 1];
+        }
+        pointCount++;
+        
+        //insert it and update the error of the two new segments
+        points[worstSegment + 1] = splitPoint;
+        errors[worstSegment] = NTC_getSegmentError(coefficients, points[worstSegment], points[worstSegment + 1], unit, NULL);
+        errors[worstSegment + 1] = NTC_getSegmentError(coefficients, points[worstSegment + 1], points[worstSegment + 2], unit, NULL);
+    }
+    
+//points are placed, now create the actual PWL
+    Pwl_t * pwl = PWL_create(NULL, pointCount, 1, 1);
+    
+    if(pwl != NULL){
+        for(uint32_t i = 0; i < pointCount; i++){
+            //same row format as NTC_generatePWL(): {resistance,temperature,dY/dX}
+            pwl->data[i * 3] = points[i];
+            pwl->data[i * 3 + 1] = NTC_getTemperatureAtResistance(coefficients, (float) points[i], unit);
+        }
+        
+        PWL_computeDerivatives(pwl);
+        PWL_checkMonotonicity(pwl);
+        
+        //the placement assumed an exact derivative, measure what the lookup with the rounded one actually achieves
+        if(achievedError != NULL) *achievedError = NTC_getPwlError(pwl, coefficients, unit);
+    }
+    
+    UTIL_FREE(points);
+    UTIL_FREE(errors);
+    
+    return pwl;
+}
+
+/*
+ * calculates the largest difference between a straight line from startResistance to endResistance and the actual NTC curve
+ * 
+ * the segment is checked at NTC_ADAPTIVE_SAMPLES points (or every ohm if it is smaller than that). If worstResistance isn't NULL the resistance with the largest error is written to it
+ */
+static int32_t NTC_getSegmentError(NTC_Coefficients_t * coefficients, int32_t startResistance, int32_t endResistance, NTC_TemperatureUnit_t unit, int32_t * worstResistance){
+    //calculate the end points the same way the generator will
+    int32_t startY = NTC_getTemperatureAtResistance(coefficients, (float) startResistance, unit);
+    int32_t endY = NTC_getTemperatureAtResistance(coefficients, (float) endResistance, unit);
+    
+    int32_t span = endResistance - startResistance;
+    int32_t sampleCount = (span - 1 < NTC_ADAPTIVE_SAMPLES) ? span - 1 : NTC_ADAPTIVE_SAMPLES;
+    
+    int32_t worstError = 0;
+    int32_t worstX = startResistance + span / 2;
+    
+    //check the points inside of the segment, the end points are exact anyway
+    for(int32_t i = 1; i <= sampleCount; i++){
+        int32_t localX = (int32_t) (((int64_t) span * i) / (sampleCount + 1));
+        
+        //the derivative will be rounded to at least PWL_MAX_SLOPE_SHIFT bits later, so just use the exact line here
+        int32_t pwlY = (int32_t) (((int64_t) (endY - startY) * localX) / span) + startY;
+        int32_t error = abs(pwlY - NTC_getTemperatureAtResistance(coefficients, (float) (startResistance + localX), unit));
+        
+        if(error > worstError){
+            worstError = error;
+            worstX = startResistance + localX;
+        }
+    }
+    
+    if(worstResistance != NULL) *worstResistance = worstX;
+    return worstError;
+}
+
+/*
+ * largest difference between PWL_getY() and the actual NTC curve, checked at NTC_ADAPTIVE_SAMPLES points in each segment of the PWL
+ */
+static int32_t NTC_getPwlError(const Pwl_t * pwl, NTC_Coefficients_t * coefficients, NTC_TemperatureUnit_t unit){
+    int32_t worstError = 0;
+    
+    for(uint32_t segment = 0; segment + 1 < pwl->listSizeRows; segment++){
+        int32_t startX = PWL_getPointX(pwl, segment);
+        int32_t span = PWL_getPointX(pwl, segment + 1) - startX;
+        
+        //same sample positions as NTC_getSegmentError(), segments narrower than NTC_ADAPTIVE_SAMPLES ohms get every value in between checked
+        int32_t sampleCount = (span - 1 < NTC_ADAPTIVE_SAMPLES) ? span - 1 : NTC_ADAPTIVE_SAMPLES;
+        for(int32_t i = 1; i <= sampleCount; i++){
+            int32_t x = startX + (int32_t) (((int64_t) span * i) / (sampleCount + 1));
+            int32_t error = abs(PWL_getY(x, pwl) - NTC_getTemperatureAtResistance(coefficients, (float) x, unit));
+            if(error > worstError) worstError = error;
+        }
+    }
+    
+    return worstError;
+}
+
+float NTC_getResistanceAtTemperature(NTC_Coefficients_t * coefficients, int32_t temperature, NTC_TemperatureUnit_t unit){
+    //convert temperature to Kelvin
+    float t1_K = NTC_unitToKelvin(temperature, unit);
+    
+    if(coefficients->model == NTC_MODEL_STEINHART_HART){
+        //solve 1/T = A + B * ln(R) + C * ln(R)^3 for ln(R). Without C that is just linear
+        if(coefficients->C == 0) return exp(((1 / t1_K) - coefficients->A) / coefficients->B);
+        
+        //otherwise it is a depressed cubic: x^3 + p * x + q = 0 with p = B/C and q = (A - 1/T)/C, which has a single real solution
+        float q = (coefficients->A - (1 / t1_K)) / coefficients->C;
+        float p = coefficients->B / coefficients->C;
+        float root = sqrt((p * p * p) / 27 + (q * q) / 4);
+        return exp(cbrt(root - q / 2) - cbrt(root + q / 2));
+    }
+    
+    //calculate Resistance according to Beta formula
+    // R1 = R0 * exp(Beta * (1/T1 - 1/T0))
+    return coefficients->R0 * exp(coefficients->Beta * ((1/t1_K) - (1/coefficients->T0)));
+}
+
+int32_t NTC_getTemperatureAtResistance(NTC_Coefficients_t * coefficients, float resistance, NTC_TemperatureUnit_t unit){
+    float temperature_K;
+    
+    if(coefficients->model == NTC_MODEL_STEINHART_HART){
+        //use the Steinhart-Hart equation: 1/T = A + B * ln(R) + C * ln(R)^3
+        float lnR = log(resistance);
+        temperature_K = 1.0 / (coefficients->A + coefficients->B * lnR + coefficients->C * lnR * lnR * lnR);
+    }else{
+        //use the Beta formula to calculate the temperature
+        temperature_K = 1.0 / ( (log(resistance / coefficients->R0) / coefficients->Beta ) + 1.0 / coefficients->T0);
+    }
+    
+    //return the value after converting to the desired unit
+    return NTC_kelvinToUnit(temperature_K, unit);
+}
+
+static int32_t NTC_kelvinToUnit(float temperature_K, NTC_TemperatureUnit_t unit){
+    switch(unit){
+        case NTC_MILLI_KELVIN:
+            return (int32_t) (temperature_K * 1000.0);
+            
+        case NTC_MILLI_DEG_CELSIUS:
+            return (int32_t) ((temperature_K - 273.15) * 1000.0);
+            
+        //TODO: implement conversion to Fahrenheit
+            
+        default: 
+            return 0;
+    }
+}
+
+static float NTC_unitToKelvin(int32_t temperature, NTC_TemperatureUnit_t unit){
+    //convert from a temperature value with specified unit to Kelvin
+    switch(unit){
+        case NTC_MILLI_KELVIN:
+            return (float) temperature / 1000.0;
+            
+        case NTC_MILLI_DEG_CELSIUS:
+            return ((float) temperature / 1000.0) + 273.15;
+            
+        //TODO: implement conversion from Fahrenheit
+            
+        default: 
+            return 0;
+    }
+}
+
+/*
+ * fixed point NTC conversion, same results as NTC_getTemperatureAtResistance() and NTC_getResistanceAtTemperature() but without any float math or libm calls
+ * 
+ * usage: convert the coefficients once, then use the fixed point functions as often as needed
+ *      NTC_FixedCoefficients_t ntcFixed;
+ *      NTC_initFixed(&ntcFixed, &ntcCoefficients);
+ *      int32_t temperature = NTC_getTemperatureAtResistanceFixed(&ntcFixed, resistance, NTC_MILLI_DEG_CELSIUS);
+ * 
+ *      ln(R) is calculated with an integer log2 (64 segment table with a second order correction, error below 1e-6) and the resistance with the equivalent exp2,
+ *      1/T is a Q40 value calculated with one 64 bit division. For the Steinhart-Hart model the resistance is found with NTC_FIXED_ITERATIONS steps of Newton's method
+ * 
+ *      Error compared to the double precision formulas, for 100 Ohm to 4 MOhm and 200 to 450 K:
+ *          temperature: within +-1 mK (plus the integer resistance step, at 100 Ohm one Ohm is around 20 mK for a typical Beta of 3950)
+ *          resistance:  within 0.001% or +-1 Ohm, whichever is larger
+ * 
+ *      NOTE: NTC_initFixed() is the only function that uses float, call it at startup or generate the NTC_FixedCoefficients_t offline
+ *      NOTE: returns 0 for invalid parameters or a resistance of 0, just like the PWL functions
+ */
+uint32_t NTC_initFixed(NTC_FixedCoefficients_t * fixed, NTC_Coefficients_t * coefficients){
+    if(fixed == NULL || coefficients == NULL) return 0;
+    
+    fixed->model = coefficients->model;
+    
+    if(coefficients->model == NTC_MODEL_STEINHART_HART){
+        //B is the main term of the equation, without it we don't even have an NTC
+        if(coefficients->B <= 0) return 0;
+        
+        fixed->A = llround((double) coefficients->A * (double) (1ULL << 40));
+        fixed->B = llround((double) coefficients->B * (double) (1ULL << 40));
+        fixed->C = llround((double) coefficients->C * (double) (1ULL << 48));
+    }else{
+        if(coefficients->Beta <= 0 || coefficients->R0 <= 0 || coefficients->T0 <= 0) return 0;
+        
+        fixed->log2R0 = (int32_t) llround(log2(coefficients->R0) * (double) (1 << 24));
+        fixed->inverseT0 = llround((double) (1ULL << 40) / coefficients->T0);
+        fixed->ln2OverBeta = llround(NTC_LN2 / coefficients->Beta * (double) (1ULL << 40));
+        fixed->betaOverLn2 = llround(coefficients->Beta / NTC_LN2 * (double) (1 << 16));
+    }
+    
+    return 1;
+}
+
+int32_t NTC_getTemperatureAtResistanceFixed(const NTC_FixedCoefficients_t * fixed, uint32_t resistance, NTC_TemperatureUnit_t unit){
+    if(fixed == NULL || resistance == 0) return 0;
+    
+    //log2(R) in Q24
+    int64_t log2R = NTC_log2Fixed(resistance);
+    int64_t inverseT;
+    
+    if(fixed->model == NTC_MODEL_STEINHART_HART){
+        //1/T = A + B * ln(R) + C * ln(R)^3
+        int64_t lnR = (log2R * NTC_LN2_Q30) >> 30;             //Q24
+        int64_t lnR3 = (((lnR * lnR) >> 24) * lnR) >> 32;     //Q16
+        inverseT = fixed->A + ((fixed->B * lnR) >> 24) + ((fixed->C * lnR3) >> 24);
+    }else{
+        //Beta formula: 1/T = ln(R / R0) / Beta + 1/T0
+        inverseT = fixed->inverseT0 + (((log2R - fixed->log2R0) * fixed->ln2OverBeta) >> 24);
+    }
+    
+    //nothing has a temperature below 0 K, that is just an invalid resistance for the coefficients
+    if(inverseT <= 0) return 0;
+    
+    //T = 1 / (1/T) in mK, rounded
+    int64_t temperature_mK = ((1000LL << 40) + inverseT / 2) / inverseT;
+    return NTC_milliKelvinToUnit(temperature_mK, unit);
+}
+
+uint32_t NTC_getResistanceAtTemperatureFixed(const NTC_FixedCoefficients_t * fixed, int32_t temperature, NTC_TemperatureUnit_t unit){
+    int64_t temperature_mK = NTC_unitToMilliKelvin(temperature, unit);
+    if(fixed == NULL || temperature_mK <= 0) return 0;
+    
+    //1/T in Q40
+    int64_t inverseT = ((1000LL << 40) + temperature_mK / 2) / temperature_mK;
+    int64_t log2R;
+    
+    if(fixed->model == NTC_MODEL_STEINHART_HART){
+        //solve C * x^3 + B * x + A - 1/T = 0 for x = ln(R) with Newton's method. The C term is tiny, so the solution without it is already a very good start
+        int64_t lnR = ((inverseT - fixed->A) * (1LL << 24)) / fixed->B;     //Q24
+        
+        for(uint32_t i = 0; i < NTC_FIXED_ITERATIONS; i++){
+            int64_t lnR2 = (lnR * lnR) >> 24;                          //Q24
+            int64_t lnR3 = (lnR2 * lnR) >> 32;                         //Q16
+            int64_t f = fixed->A + ((fixed->B * lnR) >> 24) + ((fixed->C * lnR3) >> 24) - inverseT;  //Q40
+            int64_t dfdx = fixed->B + ((3 * fixed->C * lnR2) >> 32);                                //Q40
+            
+            //the derivative is only this small with nonsensical coefficients
+            if(dfdx <= 0) return 0;
+            
+            lnR -= (f * (1LL << 24)) / dfdx;
+        }
+        
+        log2R = (lnR * NTC_INVERSE_LN2_Q30) >> 30;
+    }else{
+        //Beta formula: log2(R) = log2(R0) + Beta / ln(2) * (1/T - 1/T0)
+        log2R = fixed->log2R0 + (((inverseT - fixed->inverseT0) * fixed->betaOverLn2) >> 32);
+    }
+    
+    return NTC_exp2Fixed(log2R);
+}
+
+//log2(1 + i/64) in Q30, two more entries than segments for the second order correction
+static const int32_t ntcLog2Table[] = {0, 24017256, 47667823, 70962728, 93912511, 116527248, 138816582, 160789745, 182455581, 203822568, 224898839, 245692198, 266210141, 286459867, 306448299, 326182095, 345667660, 364911162, 383918542, 402695523, 421247625, 439580170, 457698295, 475606957, 493310944, 510814882, 528123241, 545240343, 562170370, 578917365, 595485245, 611877800, 628098702, 644151509, 660039669, 675766525, 691335320, 706749198, 722011213, 737124328, 752091421, 766915285, 781598637, 796144114, 810554283, 824831638, 838978604, 852997541, 866890747, 880660455, 894308843, 907838029, 921250079, 934547002, 947730758, 960803257, 973766362, 986621888, 999371606, 1012017244, 1024560487, 1037002979, 1049346328, 1061592099, 1073741824, 1085796998};
+
+//2^(i/64) in Q30, same layout as ntcLog2Table
+static const uint32_t ntcExp2Table[] = {1073741824, 1085434106, 1097253708, 1109202018, 1121280436, 1133490379, 1145833280, 1158310587, 1170923762, 1183674286, 1196563654, 1209593378, 1222764986, 1236080024, 1249540052, 1263146652, 1276901417, 1290805962, 1304861917, 1319070932, 1333434672, 1347954824, 1362633090, 1377471191, 1392470869, 1407633882, 1422962010, 1438457051, 1454120821, 1469955159, 1485961921, 1502142985, 1518500250, 1535035634, 1551751076, 1568648537, 1585730000, 1602997467, 1620452965, 1638098541, 1655936265, 1673968228, 1692196547, 1710623359, 1729250827, 1748081133, 1767116489, 1786359126, 1805811301, 1825475297, 1845353420, 1865448001, 1885761398, 1906295993, 1927054196, 1948038440, 1969251188, 1990694927, 2012372174, 2034285470, 2056437387, 2078830522, 2101467502, 2124350982, 2147483648, 2170868212};
+
+/*
+ * log2(x) in Q24, x must not be 0
+ * 
+ * the table is interpolated linearly with a correction for the curvature from the second difference of the table: f(i + d) = f(i) + d * (f(i+1) - f(i)) - d * (1 - d) / 2 * (f(i) - 2 f(i+1) + f(i+2))
+ */
+static int32_t NTC_log2Fixed(uint32_t x){
+    //integer part is the position of the highest set bit, the rest is normalised to a Q31 fraction
+    uint32_t integer = 31 - __builtin_clz(x);
+    uint32_t fraction = (x << (31 - integer)) - 0x80000000;
+    
+    //top 6 bits select the segment, the other 25 are the position in it
+    uint32_t i = fraction >> 25;
+    int64_t d = fraction & 0x1FFFFFF;
+    
+    int64_t linear = ntcLog2Table[i] + ((((int64_t) ntcLog2Table[i + 1] - ntcLog2Table[i]) * d) >> 25);
+    int64_t secondDifference = (int64_t) ntcLog2Table[i] - 2 * (int64_t) ntcLog2Table[i + 1] + ntcLog2Table[i + 2];
+    int64_t halfDD = (d * ((1 << 25) - d)) >> 26;
+    int64_t value = linear - ((secondDifference * halfDD) >> 25);    //Q30
+    
+    return (int32_t) ((integer << 24) + ((value + 32) >> 6));
+}
+
+/*
+ * 2^x with x in Q24, rounded to an integer and saturated to the range of uint32_t. Same interpolation as NTC_log2Fixed()
+ */
+static uint32_t NTC_exp2Fixed(int64_t x){
+    if(x >= (32LL << 24)) return UINT32_MAX;
+    if(x < -(1LL << 24)) return 0;
+    
+    //floor of x and the Q24 fraction
+    int32_t integer = (int32_t) (x >> 24);
+    uint32_t fraction = (uint32_t) (x & 0xFFFFFF);
+    
+    uint32_t i = fraction >> 18;
+    int64_t d = fraction & 0x3FFFF;
+    
+    int64_t linear = ntcExp2Table[i] + ((((int64_t) ntcExp2Table[i + 1] - ntcExp2Table[i]) * d) >> 18);
+    int64_t secondDifference = (int64_t) ntcExp2Table[i] - 2 * (int64_t) ntcExp2Table[i + 1] + ntcExp2Table[i + 2];
+    int64_t halfDD = (d * ((1 << 18) - d)) >> 19;
+    int64_t mantissa = linear - ((secondDifference * halfDD) >> 18);  //Q30, 1 to 2
+    
+    //scale by 2^integer and round
+    uint64_t result;
+    if(integer >= 0){
+        result = ((uint64_t) mantissa << integer) + (1 << 29);
+        result >>= 30;
+    }else{
+        uint32_t shift = 30 - integer;
+        result = ((uint64_t) mantissa + (1ULL << (shift - 1))) >> shift;
+    }
+    
+    return (result > UINT32_MAX) ? UINT32_MAX : (uint32_t) result;
+}
+
+static int32_t NTC_milliKelvinToUnit(int64_t temperature_mK, NTC_TemperatureUnit_t unit){
+    switch(unit){
+        case NTC_MILLI_KELVIN:
+            return (int32_t) temperature_mK;
+            
+        case NTC_MILLI_DEG_CELSIUS:
+            return (int32_t) (temperature_mK - 273150);
+            
+        case NTC_MILLI_DEG_FAHRENHEIT:{
+            //F = K * 9/5 - 459.67, rounded to the nearest milli degree
+            int64_t scaled = temperature_mK * 9;
+            return (int32_t) ((scaled + ((scaled < 0) ? -2 : 2)) / 5 - 459670);
+        }
+            
+        default: 
+            return 0;
+    }
+}
+
+static int64_t NTC_unitToMilliKelvin(int32_t temperature, NTC_TemperatureUnit_t unit){
+    switch(unit){
+        case NTC_MILLI_KELVIN:
+            return temperature;
+            
+        case NTC_MILLI_DEG_CELSIUS:
+            return (int64_t) temperature + 273150;
+            
+        case NTC_MILLI_DEG_FAHRENHEIT:{
+            //K = (F + 459.67) * 5/9, rounded to the nearest milli Kelvin
+            int64_t scaled = ((int64_t) temperature + 459670) * 5;
+            return (scaled + ((scaled < 0) ? -4 : 4)) / 9;
+        }
+            
+        default: 
+            return 0;
+    }
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/*
+ * Config file tool. Looks through a given file and finds the first line that contains a definition of it
+ * 
+ * Line format: 
+ *      //a very nice comment, as long as it contains "//" as the first two non space characters
+ *      aVeryNiceKeyName = a very nice value with spaces that ends with a newline char //a comment after this is also possible :)
+ * 
+ *      NOTE: value will be trimmed of leading and lagging spaces
+ *      NOTE: lines longer than CONFIG_BUFFER_SIZE - CONFIG_BLOCK_SIZE chars are skipped, unless the key and value are complete before a comment (see CONFIG_nextToken())
+ *      NOTE: this reads the whole file for every key, if you need more than one use CONFIG_load() instead
+ *      NOTE: the returned value is allocated with UTIL_malloc(), free it with UTIL_free() once it isn't needed anymore
+ *      NOTE: the returned value is not the only allocation, a block buffer of CONFIG_BUFFER_SIZE bytes is needed while the file is read. 
+ *            It is freed again before this returns
+ */
+
+#if __has_include("ff.h")
+char * CONFIG_getKey(FIL * file, char * keyToFind){
+    //check if the file is value
+    if((uintptr_t) file < 0xff){
+        //no its not, either NULL or an error code. Just return
+        return NULL;
+    }
+    
+    char * buffer = utilAllocate(CONFIG_BUFFER_SIZE);
+    if(buffer == NULL) return NULL;  //no space available for the block buffer
+    
+    //start reading at the beginning of the file
+    ConfigTokenizer_t tokenizer;
+    if(!CONFIG_initTokenizer(&tokenizer, file, buffer, CONFIG_BUFFER_SIZE)){
+        UTIL_FREE(buffer);
+        return NULL;
+    }
+    
+    //go through every key/value pair of the file
+    uint32_t keyLength = strlen(keyToFind);
+    ConfigToken_t token;
+    while(CONFIG_nextToken(&tokenizer, &token)){
+        //now check if the key matches the one we are looking for
+        if(token.keyLength == keyLength && memcmp(token.key, keyToFind, keyLength) == 0){
+            //yes we found it!! :D the token only points into the block buffer, so copy the value into its own buffer and return that
+            char * ret = utilAllocate(token.valueLength + 1);
+            if(ret != NULL){
+                memcpy(ret, token.value, token.valueLength);
+                ret[token.valueLength] = 0;
+                UTIL_trace(UTIL_TRACE_DEBUG, "key matches! final value return=\"%s\" ", ret);
+                UTIL_traceEvent(UTIL_TRACE_DEBUG, UTIL_EVENT_CONFIG_KEY_FOUND, keyLength, token.valueLength);
+            }
+            
+            UTIL_FREE(buffer);
+            return ret;
+        }
+    }
+    
+    //free the block buffer
+    UTIL_FREE(buffer);   
+    return NULL;
+}
+
+/*
+ * Config file tool. Same as CONFIG_getKey() but finds a whole set of keys in one pass over the file
+ * 
+ * usage:
+ *      const char * keys[] = {"maxCurrent", "minVoltage", "name"};
+ *      char * values[3];
+ *      CONFIG_getKeys(file, keys, 3, values);
+ * 
+ *      out[i] is the value of keys[i] (allocated with UTIL_malloc(), free it with UTIL_free() once it isn't needed anymore) or NULL if the key isn't in the file
+ *      The keys are hashed and sorted once, so every line only costs a hash and a binary search no matter how many keys we are looking for
+ * 
+ *      returns the number of keys that were found
+ */
+uint32_t CONFIG_getKeys(FIL * file, const char * keys[], size_t n, char * out[]){
+    if(keys == NULL || out == NULL) return 0;
+    for(size_t i = 0; i < n; i++) out[i] = NULL;
+    if(n == 0) return 0;
+    
+    //table of the hashes of all keys we are looking for, keyOffset is the index in keys[] here
+    ConfigEntry_t * table = utilAllocate(n * sizeof(ConfigEntry_t));
+    char * buffer = utilAllocate(CONFIG_BUFFER_SIZE);
+    if(table == NULL || buffer == NULL){
+        UTIL_FREE(table);
+        UTIL_FREE(buffer);
+        return 0;
+    }
+    
+    for(size_t i = 0; i < n; i++){
+        table[i].hash = CONFIG_hash(keys[i], strlen(keys[i]));
+        table[i].keyOffset = i;
+        table[i].valueOffset = 0;
+    }
+    qsort(table, n, sizeof(ConfigEntry_t), CONFIG_compareEntries);
+    
+    uint32_t found = 0;
+    
+    ConfigTokenizer_t tokenizer;
+    if(CONFIG_initTokenizer(&tokenizer, file, buffer, CONFIG_BUFFER_SIZE)){
+        ConfigToken_t token;
+        
+        //go through the file once, stop early once we have everything
+        while(found < n && CONFIG_nextToken(&tokenizer, &token)){
+            uint32_t hash = CONFIG_hash(token.key, token.keyLength);
+            
+            for(uint32_t entry = CONFIG_findHash(table, n, hash); entry < n && table[entry].hash == hash; entry++){
+                uint32_t key = table[entry].keyOffset;
+                
+                //the first definition of a key wins, just like in CONFIG_getKey()
+                if(out[key] != NULL) continue;
+                if(strlen(keys[key]) != token.keyLength || memcmp(keys[key], token.key, token.keyLength) != 0) continue;
+                
+                out[key] = utilAllocate(token.valueLength + 1);
+                if(out[key] == NULL) continue;
+                memcpy(out[key], token.value, token.valueLength);
+                out[key][token.valueLength] = 0;
+                found++;
+            }
+        }
+    }
+    
+    UTIL_FREE(table);
+    UTIL_FREE(buffer);
+    return found;
+}
+
+/*
+ * Config tokenizer - reads a config file in blocks of CONFIG_BLOCK_SIZE and splits it into key/value pairs without copying anything
+ * 
+ * usage: 
+ *      ConfigTokenizer_t tokenizer;
+ *      CONFIG_initTokenizer(&tokenizer, file, buffer, sizeof(buffer));
+ *      ConfigToken_t token;
+ *      while(CONFIG_nextToken(&tokenizer, &token)){
+ *          //token.key/keyLength and token.value/valueLength point into the buffer
+ *      }
+ * 
+ *      The file is read from the beginning, all reads are whole blocks so FatFs can read complete sectors straight into the buffer.
+ *      bufferSize must be a multiple of CONFIG_BLOCK_SIZE and at least two blocks, lines can be up to bufferSize - CONFIG_BLOCK_SIZE chars long
+ * 
+ *      returns 0 if the file is invalid or the seek failed
+ */
+uint32_t CONFIG_initTokenizer(ConfigTokenizer_t * tokenizer, FIL * file, char * buffer, uint32_t bufferSize){
+    if(tokenizer == NULL || (uintptr_t) file < 0xff || buffer == NULL || bufferSize < 2 * CONFIG_BLOCK_SIZE) return 0;
+    
+    FRESULT seekRes = f_lseek(file, 0);
+    if(seekRes != FR_OK){
+        UTIL_trace(UTIL_TRACE_ERROR, "seek failed (%d)", seekRes);
+        UTIL_traceEvent(UTIL_TRACE_ERROR, UTIL_EVENT_CONFIG_SEEK_FAILED, seekRes, 0);
+        return 0;
+    }
+    
+    tokenizer->file = file;
+    tokenizer->buffer = buffer;
+    tokenizer->bufferSize = bufferSize;
+    tokenizer->start = 0;
+    tokenizer->end = 0;
+    tokenizer->endOfFile = 0;
+    tokenizer->skipLine = 0;
+    tokenizer->crc = 0;
+    
+    return 1;
+}
+
+/*
+ * finds the next key/value pair, returns 0 at the end of the file
+ * 
+ * the token points into the buffer of the tokenizer and is only valid until the next call
+ * 
+ *      NOTE: a line longer than bufferSize - CONFIG_BLOCK_SIZE is skipped. If a comment starts before that, the key and value in front of it are complete and still returned
+ */
+uint32_t CONFIG_nextToken(ConfigTokenizer_t * tokenizer, ConfigToken_t * token){
+    if(tokenizer == NULL || token == NULL) return 0;
+    
+    //longest line we accept, anything longer might not fit into the buffer depending on where in a block it starts
+    uint32_t maxLength = tokenizer->bufferSize - CONFIG_BLOCK_SIZE;
+    
+    while(1){
+        const char * line = &tokenizer->buffer[tokenizer->start];
+        uint32_t available = tokenizer->end - tokenizer->start;
+        const char * lineEnd = memchr(line, '\n', available);
+        
+        //got a complete line? (the last line of the file might not have a newline)
+        if(lineEnd != NULL || (tokenizer->endOfFile && available > 0)){
+            uint32_t length = (lineEnd != NULL) ? (uint32_t) (lineEnd - line) : available;
+            tokenizer->start += (lineEnd != NULL) ? length + 1 : length;
+            
+            //this is the end of a line that was too long, we already skipped its start
+            if(tokenizer->skipLine){
+                tokenizer->skipLine = 0;
+                continue;
+            }
+            
+            //too long? Then only use it if the comment starts early enough that the key and value are complete
+            if(length > maxLength){
+                if(CONFIG_findComment(line, maxLength) < maxLength && CONFIG_tokenizeLine(line, maxLength, token)) return 1;
+                continue;
+            }
+            
+            if(CONFIG_tokenizeLine(line, length, token)) return 1;
+            continue;
+        }
+        
+        //nothing left at all?
+        if(tokenizer->endOfFile) return 0;
+        
+        //the line continues in the next block. Move its start to the front of the buffer (nothing of it is needed if we are skipping it anyway)
+        if(tokenizer->skipLine) available = 0;
+        memmove(tokenizer->buffer, line, available);
+        tokenizer->start = 0;
+        tokenizer->end = available;
+        
+        //read as many complete blocks as there is space for behind it
+        uint32_t readSize = ((tokenizer->bufferSize - available) / CONFIG_BLOCK_SIZE) * CONFIG_BLOCK_SIZE;
+        
+        if(readSize == 0){
+            //the line doesn't fit the buffer. If there is a comment in the part we have the key and value are still complete
+            tokenizer->start = tokenizer->end;
+            tokenizer->skipLine = 1;
+            
+            if(CONFIG_findComment(tokenizer->buffer, maxLength) < maxLength && CONFIG_tokenizeLine(tokenizer->buffer, maxLength, token)) return 1;
+            continue;
+        }
+        
+        UINT bytesRead = 0;
+        FRESULT res = f_read(tokenizer->file, &tokenizer->buffer[available], readSize, &bytesRead);
+        if(res != FR_OK){
+            UTIL_trace(UTIL_TRACE_ERROR, "read failed (%d)", res);
+            UTIL_traceEvent(UTIL_TRACE_ERROR, UTIL_EVENT_CONFIG_READ_FAILED, res, 0);
+        }
+        
+        //less than we asked for means the file ended
+        if(res != FR_OK || bytesRead < readSize) tokenizer->endOfFile = 1;
+        tokenizer->crc = CONFIG_crc32(tokenizer->crc, &tokenizer->buffer[available], bytesRead);
+        tokenizer->end += bytesRead;
+    }
+}
+
+/*
+ * position of the first comment sequence ("//") in the line, length if there is none
+ */
+static uint32_t CONFIG_findComment(const char * line, uint32_t length){
+    for(uint32_t i = 0; i + 1 < length; i++){
+        if(line[i] == '/' && line[i + 1] == '/') return i;
+    }
+    return length;
+}
+
+/*
+ * finds key and value in a line of a config file, see CONFIG_getKey() for the format
+ * 
+ *      key:   first word of the line (ends at a space, a special character or the '=')
+ *      value: everything after the '=' without leading and trailing spaces
+ *      anything from the first "//" onwards is a comment. The line is never modified
+ * 
+ * returns 1 if the line contains a key/value pair
+ */
+static uint32_t CONFIG_tokenizeLine(const char * line, uint32_t length, ConfigToken_t * token){
+    //cut off the comment, and anything after a string terminator
+    const char * terminator = memchr(line, 0, length);
+    if(terminator != NULL) length = terminator - line;
+    length = CONFIG_findComment(line, length);
+    
+    //skip leading spaces
+    uint32_t i = 0;
+    while(i < length && CONFIG_isSpace(line[i])) i++;
+    
+    //the key must start with something that isn't the '='
+    if(i == length || line[i] == '=') return 0;
+    
+    //key ends with the first space, special character or '='
+    uint32_t keyStart = i;
+    while(i < length && !CONFIG_isSpace(line[i]) && line[i] != '=') i++;
+    uint32_t keyEnd = i;
+    
+    //find the '=', anything between it and the key is ignored
+    while(i < length && line[i] != '=') i++;
+    if(i == length) return 0;
+    i++;
+    
+    //skip the spaces in front of the value
+    while(i < length && CONFIG_isSpace(line[i])) i++;
+    if(i == length) return 0;
+    
+    //and the ones after it
+    uint32_t valueEnd = length;
+    while(valueEnd > i && CONFIG_isSpace(line[valueEnd - 1])) valueEnd--;
+    
+    token->key = &line[keyStart];
+    token->keyLength = keyEnd - keyStart;
+    token->value = &line[i];
+    token->valueLength = valueEnd - i;
+    
+    return 1;
+}
+
+//spaces and special characters separate the tokens of a line
+static inline uint32_t CONFIG_isSpace(char c){
+    return (utilCharTable[(uint8_t) c] & UTIL_CHAR_SPACE) != 0;
+}
+
+#endif
+
+/*
+ * hash of a config key (FNV-1a), used to sort the entries of a Config_t
+ */
+static uint32_t CONFIG_hash(const char * key, uint32_t length){
+    uint32_t hash = 2166136261u;
+    for(uint32_t i = 0; i < length; i++) hash = (hash ^ (uint8_t) key[i]) * 16777619u;
+    return hash;
+}
+
+/*
+ * Config file tool. Reads the whole config file once and creates an index of all key/value pairs in it, so any number of keys can be looked up without touching the file again
+ * 
+ * usage:
+ *      Config_t * cfg = CONFIG_load(file);
+ *      const char * value = CONFIG_get(cfg, "aVeryNiceKeyName");
+ *      ...
+ *      CONFIG_free(cfg);
+ * 
+ *      Line format is the same as for CONFIG_getKey(). If a key is defined more than once the first definition is used, just like CONFIG_getKey() would
+ * 
+ *      The index is one single allocation: the header, the entries sorted by the hash of their key and all key and value strings after that. 
+ *      The entries only contain offsets into the string block, so the whole thing can be moved or copied with memcpy (CONFIG_loadCached() writes it to a file like that)
+ * 
+ *      Values that are numbers are also parsed already, so CONFIG_getInt() doesn't have to touch the string again
+ * 
+ *      NOTE: the file is read twice, the first pass counts the entries and the size of their strings so the index can be allocated in one go
+ */
+#if __has_include("ff.h")
+Config_t * CONFIG_load(FIL * file){
+    char * buffer = utilAllocate(CONFIG_BUFFER_SIZE);
+    if(buffer == NULL) return NULL;  //no space available for the block buffer
+    
+    Config_t * cfg = NULL;
+    uint32_t entryCount = 0;
+    uint32_t stringSize = 0;
+    uint32_t crc = 0;
+    
+    for(uint32_t pass = 0; pass < 2; pass++){
+        //start at the beginning of the file again
+        ConfigTokenizer_t tokenizer;
+        if(!CONFIG_initTokenizer(&tokenizer, file, buffer, CONFIG_BUFFER_SIZE)){
+            UTIL_FREE(buffer);
+            UTIL_FREE(cfg);
+            return NULL;
+        }
+        
+        uint32_t entry = 0;
+        uint32_t stringPosition = 0;
+        ConfigToken_t token;
+        
+        while(CONFIG_nextToken(&tokenizer, &token)){
+            //the strings get a terminator in the index so CONFIG_get() can return them directly
+            uint32_t keySize = token.keyLength + 1;
+            uint32_t valueSize = token.valueLength + 1;
+            
+            if(cfg != NULL){
+                //second pass, copy the strings into the index. Stop if the file somehow grew in between the passes
+                if(entry >= entryCount || stringPosition + keySize + valueSize > stringSize) break;
+                
+                char * strings = CONFIG_getStrings(cfg);
+                memcpy(&strings[stringPosition], token.key, token.keyLength);
+                strings[stringPosition + token.keyLength] = 0;
+                memcpy(&strings[stringPosition + keySize], token.value, token.valueLength);
+                strings[stringPosition + keySize + token.valueLength] = 0;
+                
+                ConfigEntry_t * current = &cfg->entries[entry];
+                current->hash = CONFIG_hash(token.key, token.keyLength);
+                current->keyOffset = stringPosition;
+                current->valueOffset = stringPosition + keySize;
+                
+                //parse numbers now, that way neither CONFIG_getInt() nor a cached index ever needs to do it again
+                CONFIG_parseValue(current, &strings[current->valueOffset]);
+            }
+            
+            entry++;
+            stringPosition += keySize + valueSize;
+        }
+        
+        if(cfg == NULL){
+            //first pass done, now we know how much memory the index needs
+            entryCount = entry;
+            stringSize = stringPosition;
+            
+            cfg = utilAllocate(sizeof(Config_t) + entryCount * sizeof(ConfigEntry_t) + stringSize);
+            if(cfg == NULL){
+                UTIL_FREE(buffer);
+                return NULL;
+            }
+        }else{
+            //the file might also have shrunk in between the passes
+            entryCount = entry;
+            crc = tokenizer.crc;
+        }
+        
+        cfg->entryCount = entryCount;
+        cfg->stringSize = stringSize;
+    }
+    
+    UTIL_FREE(buffer);
+    
+    //remember where the index came from. The timestamp isn't known here, CONFIG_loadCached() sets it
+    cfg->sourceSize = f_size(file);
+    cfg->sourceTimestamp = 0;
+    cfg->sourceCrc = crc;
+    
+    //sort the entries by hash. Entries with the same hash stay in the order of the file as their key offsets increase from line to line
+    qsort(cfg->entries, cfg->entryCount, sizeof(ConfigEntry_t), CONFIG_compareEntries);
+    
+    return cfg;
+}
+
+/*
+ * Config file tool. Same as CONFIG_load() but keeps a binary copy of the index in a cache file, so the text only needs to be parsed again after it changed
+ * 
+ * usage:
+ *      FILINFO info;
+ *      f_stat("config.txt", &info);
+ *      Config_t * cfg = CONFIG_loadCached(file, cacheFile, ((uint32_t) info.fdate << 16) | info.ftime);
+ *      ...
+ *      CONFIG_free(cfg);
+ * 
+ *      the cache file must be opened with read and write access (f.e. FA_OPEN_ALWAYS | FA_READ | FA_WRITE). It is valid if the size, timestamp and crc32 of the config file 
+ *      match the ones it was created from, then the index is read with a single f_read() and nothing is parsed. Otherwise the config is loaded with CONFIG_load() and the cache is rewritten
+ * 
+ *      timestamp can be anything that changes when the file does, the FatFs date and time of the file work nicely. cache can also be NULL, then this just loads the file
+ * 
+ *      NOTE: the crc is only checked if the size and timestamp in the cache match, that still needs one pass over the file but it is just reading blocks. 
+ *            If even that is too slow use CONFIG_hasChanged() to decide if loading is needed at all. A cache miss reads the file just twice, like CONFIG_load()
+ *      NOTE: the index is stored as it is in memory, a cache is only valid for the same architecture (it is simply rebuilt otherwise as the version check fails)
+ */
+Config_t * CONFIG_loadCached(FIL * file, FIL * cache, uint32_t timestamp){
+    if((uintptr_t) file < 0xff) return NULL;
+    
+    //is there a matching cache?
+    Config_t * cfg = NULL;
+    if((uintptr_t) cache >= 0xff){
+        cfg = CONFIG_readCache(cache, file, timestamp);
+        if(cfg != NULL){
+            UTIL_traceEvent(UTIL_TRACE_INFO, UTIL_EVENT_CONFIG_CACHE_HIT, f_size(file), cfg->sourceCrc);
+            return cfg;
+        }
+    }
+    
+    //no, parse the file and write a new one. CONFIG_load() gets the crc of the file while it's at it
+    cfg = CONFIG_load(file);
+    UTIL_traceEvent(UTIL_TRACE_INFO, UTIL_EVENT_CONFIG_CACHE_MISS, f_size(file), (cfg != NULL) ? cfg->sourceCrc : 0);
+    if(cfg == NULL) return NULL;
+    cfg->sourceTimestamp = timestamp;
+    
+    if((uintptr_t) cache >= 0xff && !CONFIG_writeCache(cache, cfg)){
+        UTIL_trace(UTIL_TRACE_ERROR, "writing the config cache failed");
+        UTIL_traceEvent(UTIL_TRACE_ERROR, UTIL_EVENT_CONFIG_CACHE_WRITE_FAILED, CONFIG_getSize(cfg), 0);
+    }
+    
+    return cfg;
+}
+
+/*
+ * checks if a config file is different to the one the index was created from. Compares just the size and the timestamp (see CONFIG_loadCached()), so this doesn't read anything
+ * 
+ * returns 1 if the file changed and should be loaded again
+ * 
+ *      NOTE: CONFIG_load() doesn't know the timestamp of the file. Use CONFIG_loadCached() (with or without a cache file) or set sourceTimestamp yourself
+ */
+uint32_t CONFIG_hasChanged(const Config_t * cfg, FIL * file, uint32_t timestamp){
+    if(cfg == NULL || (uintptr_t) file < 0xff) return 1;
+    return f_size(file) != cfg->sourceSize || timestamp != cfg->sourceTimestamp;
+}
+
+/*
+ * loads the config file again (through the cache if one is given, see CONFIG_loadCached()) and swaps it in with CONFIG_publish()
+ * 
+ * usage: call from the task that owns the file, f.e. whenever CONFIG_hasChanged() says so. The readers keep using the old index until the new one is complete
+ * 
+ * returns 0 and keeps the old index if the file couldn't be loaded
+ */
+uint32_t CONFIG_reload(ConfigShared_t * shared, FIL * file, FIL * cache, uint32_t timestamp){
+    if(shared == NULL) return 0;
+    
+    Config_t * cfg = CONFIG_loadCached(file, cache, timestamp);
+    if(cfg == NULL) return 0;
+    
+    CONFIG_publish(shared, cfg);
+    return 1;
+}
+
+//crc32 of a whole file, returns 0 if it couldn't be read
+static uint32_t CONFIG_getFileCrc(FIL * file, uint32_t * crc){
+    char * buffer = utilAllocate(CONFIG_BUFFER_SIZE);
+    if(buffer == NULL) return 0;
+    
+    FRESULT res = f_lseek(file, 0);
+    *crc = 0;
+    
+    while(res == FR_OK){
+        UINT bytesRead = 0;
+        res = f_read(file, buffer, CONFIG_BUFFER_SIZE, &bytesRead);
+        *crc = CONFIG_crc32(*crc, buffer, bytesRead);
+        if(bytesRead < CONFIG_BUFFER_SIZE) break;
+    }
+    
+    UTIL_FREE(buffer);
+    
+    if(res != FR_OK){
+        UTIL_trace(UTIL_TRACE_ERROR, "read failed (%d)", res);
+        UTIL_traceEvent(UTIL_TRACE_ERROR, UTIL_EVENT_CONFIG_READ_FAILED, res, 0);
+    }
+    return res == FR_OK;
+}
+
+//reads the index from a cache file, returns NULL if there is none or it doesn't belong to the given source file
+static Config_t * CONFIG_readCache(FIL * cache, FIL * file, uint32_t sourceTimestamp){
+    ConfigCacheHeader_t header;
+    UINT bytesRead = 0;
+    
+    if(f_lseek(cache, 0) != FR_OK) return NULL;
+    if(f_read(cache, &header, sizeof(header), &bytesRead) != FR_OK || bytesRead != sizeof(header)) return NULL;
+    
+    //the version check includes the entry size, so a cache written by a different build of this code is never used
+    if(header.magic != CONFIG_CACHE_MAGIC || header.version != ((CONFIG_CACHE_VERSION << 16) | sizeof(ConfigEntry_t))) return NULL;
+    if(header.sourceSize != f_size(file) || header.sourceTimestamp != sourceTimestamp) return NULL;
+    if(header.imageSize < sizeof(Config_t) || header.imageSize > f_size(cache) - sizeof(header)) return NULL;
+    
+    //size and timestamp match, only now is it worth reading the whole source file for the crc
+    uint32_t crc;
+    if(!CONFIG_getFileCrc(file, &crc) || header.sourceCrc != crc) return NULL;
+    
+    //everything matches, read the whole index in one go
+    Config_t * cfg = utilAllocate(header.imageSize);
+    if(cfg == NULL) return NULL;
+    
+    if(f_read(cache, cfg, header.imageSize, &bytesRead) != FR_OK || bytesRead != header.imageSize 
+            || CONFIG_crc32(0, cfg, header.imageSize) != header.imageCrc || CONFIG_getSize(cfg) != header.imageSize){
+        UTIL_FREE(cfg);
+        return NULL;
+    }
+    
+    return cfg;
+}
+
+//writes an index into a cache file, replacing anything that was in there before
+static uint32_t CONFIG_writeCache(FIL * cache, const Config_t * cfg){
+    ConfigCacheHeader_t header;
+    header.magic = CONFIG_CACHE_MAGIC;
+    header.version = (CONFIG_CACHE_VERSION << 16) | sizeof(ConfigEntry_t);
+    header.sourceSize = cfg->sourceSize;
+    header.sourceTimestamp = cfg->sourceTimestamp;
+    header.sourceCrc = cfg->sourceCrc;
+    header.imageSize = CONFIG_getSize(cfg);
+    header.imageCrc = CONFIG_crc32(0, cfg, header.imageSize);
+    
+    UINT bytesWritten = 0;
+    if(f_lseek(cache, 0) != FR_OK) return 0;
+    if(f_write(cache, &header, sizeof(header), &bytesWritten) != FR_OK || bytesWritten != sizeof(header)) return 0;
+    if(f_write(cache, cfg, header.imageSize, &bytesWritten) != FR_OK || bytesWritten != header.imageSize) return 0;
+    
+    //cut off whatever an older and larger cache left behind
+    if(f_truncate(cache) != FR_OK) return 0;
+    return f_sync(cache) == FR_OK;
+}
+
+//crc32 (same polynomial as zlib and ethernet), nibble wise to keep the table small. Start with crc = 0, pass the result back in to continue over more data
+static uint32_t CONFIG_crc32(uint32_t crc, const void * data, uint32_t length){
+    static const uint32_t crcTable[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+    };
+    
+    const uint8_t * bytes = data;
+    crc = ~crc;
+    
+    for(uint32_t i = 0; i < length; i++){
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ crcTable[crc & 0xf];
+        crc = (crc >> 4) ^ crcTable[crc & 0xf];
+    }
+    
+    return ~crc;
+}
+
+//stores the value of an entry as mantissa and exponent if it is a number (in the format atoiFP() reads, units are ignored)
+static void CONFIG_parseValue(ConfigEntry_t * entry, const char * value){
+    int64_t mantissa;
+    int32_t exponent;
+    uint32_t truncated;
+    
+    entry->flags = 0;
+    entry->mantissa = 0;
+    entry->exponent = 0;
+    if(atoiFP_parse(value, 0, ATOIFP_IGNORE_UNIT, NULL, &mantissa, &exponent, &truncated) != ATOIFP_OK) return;
+    
+    //make the mantissa fit into 32 bits, what's dropped here would be cut off by any int32_t result anyway
+    while(mantissa > INT32_MAX || mantissa < -INT32_MAX){
+        mantissa /= 10;
+        exponent++;
+        truncated = 1;
+    }
+    
+    entry->flags = CONFIG_ENTRY_NUMBER | (truncated ? CONFIG_ENTRY_TRUNCATED : 0);
+    entry->mantissa = mantissa;
+    entry->exponent = exponent;
+}
+
+//qsort compare function for the entries of a Config_t: by hash, then by position in the file
+static int CONFIG_compareEntries(const void * a, const void * b){
+    const ConfigEntry_t * entryA = a;
+    const ConfigEntry_t * entryB = b;
+    
+    if(entryA->hash != entryB->hash) return (entryA->hash < entryB->hash) ? -1 : 1;
+    if(entryA->keyOffset != entryB->keyOffset) return (entryA->keyOffset < entryB->keyOffset) ? -1 : 1;
+    return 0;
+}
+#endif
+
+/*
+ * finds a key in a config index from CONFIG_load()
+ * 
+ * returns the value string of the key or NULL if it doesn't exist. The string belongs to the index and stays valid until CONFIG_free() is called
+ * 
+ *      NOTE: binary search over the hashes, so a lookup takes log2(entryCount) compares plus one strcmp
+ */
+const char * CONFIG_get(const Config_t * cfg, const char * key){
+    const ConfigEntry_t * entry = CONFIG_findEntry(cfg, key);
+    if(entry == NULL) return NULL;
+    
+    return &CONFIG_getStrings(cfg)[entry->valueOffset];
+}
+
+//the entry of a key in a config index, NULL if it doesn't exist
+static const ConfigEntry_t * CONFIG_findEntry(const Config_t * cfg, const char * key){
+    if(cfg == NULL || key == NULL) return NULL;
+    
+    uint32_t hash = CONFIG_hash(key, strlen(key));
+    const char * strings = CONFIG_getStrings(cfg);
+    
+    //check all entries with that hash, usually that is just one
+    for(uint32_t entry = CONFIG_findHash(cfg->entries, cfg->entryCount, hash); entry < cfg->entryCount && cfg->entries[entry].hash == hash; entry++){
+        if(strcmp(&strings[cfg->entries[entry].keyOffset], key) == 0) return &cfg->entries[entry];
+    }
+    
+    UTIL_traceEvent(UTIL_TRACE_DEBUG, UTIL_EVENT_CONFIG_KEY_MISSING, hash, cfg->entryCount);
+    return NULL;
+}
+
+//returns the first of the entries (sorted by hash) with a hash that is not smaller than the one we are looking for
+static uint32_t CONFIG_findHash(const ConfigEntry_t * entries, uint32_t count, uint32_t hash){
+    uint32_t first = 0;
+    
+    while(count > 0){
+        uint32_t half = count >> 1;
+        
+        if(entries[first + half].hash < hash){
+            first += half + 1;
+            count -= half + 1;
+        }else{
+            count = half;
+        }
+    }
+    
+    return first;
+}
+
+/*
+ * frees a config index from CONFIG_load(), together with all strings CONFIG_get() returned from it
+ */
+void CONFIG_free(Config_t * cfg){
+    if(cfg == NULL) return;
+    UTIL_FREE(cfg);
+}
+
+/*
+ * lock free access to a config index that another task can replace at any time
+ * 
+ * usage: readers put every access between CONFIG_acquire() and CONFIG_release() and hand the slot from one to the other:
+ *          uint32_t slot;
+ *          const Config_t * cfg = CONFIG_acquire(&sharedConfig, &slot);
+ *          int32_t maxCurrent = CONFIG_getInt(cfg, "maxCurrent", -3, 1000);
+ *          CONFIG_release(&sharedConfig, slot);
+ *      An index is never written after CONFIG_load() returned it, so any number of tasks can read it at the same time without a mutex or the file.
+ *      Strings from CONFIG_get() are only valid until CONFIG_release()
+ * 
+ *      The readers are counted separately for each of the two slots. A reader that comes after CONFIG_publish() swapped the index in is counted 
+ *      in the new slot, so overlapping readers can't keep the old one alive forever. Only the ones that were already there are waited for
+ * 
+ *      returns NULL if nothing was published yet, the getters just return their default then
+ * 
+ *      NOTE: never block in between, CONFIG_publish() waits for every reader that got the old index
+ */
+const Config_t * CONFIG_acquire(ConfigShared_t * shared, uint32_t * slot){
+    if(slot != NULL) *slot = 0;
+    if(shared == NULL || slot == NULL) return NULL;
+    
+    while(1){
+        //count ourselves in the slot before getting the pointer, so a CONFIG_publish() moving away from it after this point waits for us before freeing it
+        uint32_t current = __atomic_load_n(&shared->active, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&shared->readers[current], 1, __ATOMIC_SEQ_CST);
+        
+        //the slot changed in between, the publisher might not have seen us anymore. Try again with the new one
+        if(__atomic_load_n(&shared->active, __ATOMIC_SEQ_CST) != current){
+            __atomic_sub_fetch(&shared->readers[current], 1, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        
+        *slot = current;
+        return __atomic_load_n(&shared->slots[current], __ATOMIC_SEQ_CST);
+    }
+}
+
+void CONFIG_release(ConfigShared_t * shared, uint32_t slot){
+    if(shared == NULL || slot > 1) return;
+    __atomic_sub_fetch(&shared->readers[slot], 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * makes cfg the index all following CONFIG_acquire() calls get and frees the previous one once no reader can have it anymore
+ * 
+ * usage: build the new index first (CONFIG_load() is the slow part with all the SD card access, no reader waits for that) and then hand it over.
+ *      cfg belongs to shared after that, don't free it yourself. NULL just removes the current index
+ * 
+ *      NOTE: blocks until the readers of the old index are done, so only call it from a task that may wait and never between CONFIG_acquire() and CONFIG_release().
+ *            Readers that acquire after the swap don't delay it, so the wait is as long as the longest access that was running at that moment. 
+ *            A second CONFIG_publish() at the same time waits for the first one to finish
+ *      NOTE: with FreeRTOS the waits are vTaskDelay(1), so lower priority readers can finish. Without an RTOS UTIL_yield() does nothing and this is 
+ *            a busy wait: never call it from an interrupt (or anything else) that can preempt a reader, it would wait for that reader forever
+ *      NOTE: on a Cortex-M0 the atomics need __atomic_* support functions (libatomic or your own with interrupts disabled)
+ */
+void CONFIG_publish(ConfigShared_t * shared, Config_t * cfg){
+    if(shared == NULL) return;
+    
+    //one publisher at a time, otherwise a second one could fill the slot the first one is still waiting on
+    while(__atomic_exchange_n(&shared->publishing, 1, __ATOMIC_SEQ_CST)) UTIL_yield();
+    
+    //the readers of the other slot were all waited for by the last publish, so it is free to take the new index
+    uint32_t oldSlot = __atomic_load_n(&shared->active, __ATOMIC_SEQ_CST);
+    uint32_t newSlot = oldSlot ^ 1;
+    __atomic_store_n(&shared->slots[newSlot], cfg, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&shared->active, newSlot, __ATOMIC_SEQ_CST);
+    
+    //everyone who acquires after the swap is counted in the new slot. So anyone who could still have the old index is already counted in the old one
+    while(__atomic_load_n(&shared->readers[oldSlot], __ATOMIC_SEQ_CST) != 0) UTIL_yield();
+    
+    Config_t * old = shared->slots[oldSlot];
+    __atomic_store_n(&shared->slots[oldSlot], NULL, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&shared->publishing, 0, __ATOMIC_SEQ_CST);
+    
+    CONFIG_free(old);
+}
+
+/*
+ * typed getters for a config index from CONFIG_load(). The value is parsed straight from the index, nothing is allocated
+ * 
+ * CONFIG_getInt(): the value as a fixed point number, see atoiFP() (units after the number are ignored). Returns defaultValue if the key doesn't exist or its value isn't a number
+ * 
+ *      the number was already parsed by CONFIG_load(), this only scales it to baseExponent
+ * 
+ *      NOTE: a number that doesn't fit into an int32_t returns 0, just like atoiFP() does
+ */
+int32_t CONFIG_getInt(const Config_t * cfg, const char * key, int32_t baseExponent, int32_t defaultValue){
+    const ConfigEntry_t * entry = CONFIG_findEntry(cfg, key);
+    if(entry == NULL) return defaultValue;
+    
+    if(!(entry->flags & CONFIG_ENTRY_NUMBER)) return defaultValue;
+    return atoiFP_scale(entry->mantissa, entry->exponent + baseExponent, entry->flags & CONFIG_ENTRY_TRUNCATED, NULL);
+}
+
+/*
+ * CONFIG_getBool(): 1 for "1", "true", "yes", "on" and "enabled", 0 for "0", "false", "no", "off" and "disabled" (not case sensitive). 
+ *      Returns defaultValue if the key doesn't exist or the value is none of those
+ */
+uint32_t CONFIG_getBool(const Config_t * cfg, const char * key, uint32_t defaultValue){
+    const char * value = CONFIG_get(cfg, key);
+    if(value == NULL) return defaultValue;
+    
+    const char * trueNames[] = {"1", "true", "yes", "on", "enabled", "enable"};
+    const char * falseNames[] = {"0", "false", "no", "off", "disabled", "disable"};
+    
+    for(uint32_t i = 0; i < sizeof(trueNames) / sizeof(trueNames[0]); i++){
+        if(CONFIG_equalsIgnoreCase(value, trueNames[i])) return 1;
+        if(CONFIG_equalsIgnoreCase(value, falseNames[i])) return 0;
+    }
+    
+    return defaultValue;
+}
+
+/*
+ * CONFIG_getPwl(): creates a PWL from a list of points in the value: "x0 y0, x1 y1, x2 y2, ...". 
+ *      If the key doesn't exist the table can also be split up into rows "key[0]", "key[1]", ... that are appended in that order, every row must contain whole points:
+ * 
+ *      ntcTable[0] = 1k 85, 2.2k 60
+ *      ntcTable[1] = 4.7k 40, 10k 25
+ * 
+ *      the numbers are converted with atoiFPList() and the exponent of their axis (f.e. "1k 25, 2.2k 20" with xExponent 0 and yExponent 3). 
+ *      SI prefixes are fine, units are not (f.e. "1kOhm" or "1sec")
+ *      The derivatives are computed right away (preComputedDerivative = 1), so lookups in the PWL take the fast path. Free it with PWL_delete()
+ * 
+ *      Returns NULL if the key doesn't exist, a value contains anything but numbers (or one that doesn't fit into an int32_t with its exponent), 
+ *      the list has less than two points or the x values aren't in ascending order
+ */
+Pwl_t * CONFIG_getPwl(const Config_t * cfg, const char * key, int32_t xExponent, int32_t yExponent){
+    if(cfg == NULL || key == NULL) return NULL;
+    
+    const int32_t exponents[2] = {xExponent, yExponent};
+    
+    //room for the key of a row: key, "[", up to 10 digits, "]" and the terminator
+    char * rowKey = utilAllocate(strlen(key) + 13);
+    if(rowKey == NULL) return NULL;
+    
+    //count the points first so we know how large the PWL needs to be
+    uint32_t pointCount = 0;
+    const char * value;
+    for(uint32_t row = 0; (value = CONFIG_getRow(cfg, key, row, rowKey)) != NULL; row++){
+        const char * end;
+        int err;
+        uint32_t valueCount = atoiFPList(value, NULL, UINT32_MAX, exponents, 2, 0, &end, &err);
+        
+        if(err != ATOIFP_OK || *end != 0 || valueCount & 1){
+            UTIL_FREE(rowKey);
+            return NULL;
+        }
+        
+        pointCount += valueCount / 2;
+    }
+    
+    Pwl_t * pwl = (pointCount >= 2) ? PWL_create(NULL, pointCount, 1, 1) : NULL;
+    if(pwl == NULL){
+        UTIL_FREE(rowKey);
+        return NULL;
+    }
+    
+    //and now convert them, one point at a time
+    uint32_t point = 0;
+    for(uint32_t row = 0; point < pointCount && (value = CONFIG_getRow(cfg, key, row, rowKey)) != NULL; row++){
+        int32_t xy[2];
+        while(point < pointCount && atoiFPList(value, xy, 2, exponents, 2, 0, &value, NULL) == 2){
+            PWL_setValue(pwl, point, 0, xy[0]);
+            PWL_setValue(pwl, point, 1, xy[1]);
+            point++;
+        }
+    }
+    
+    UTIL_FREE(rowKey);
+    
+    //the x values must rise, otherwise the derivatives (and any lookup) would be nonsense
+    for(uint32_t row = 0; row + 1 < pointCount; row++){
+        if(PWL_getPointX(pwl, row + 1) <= PWL_getPointX(pwl, row)){
+            PWL_delete(pwl, 0);
+            return NULL;
+        }
+    }
+    
+    if(!PWL_computeDerivatives(pwl)){
+        PWL_delete(pwl, 0);
+        return NULL;
+    }
+    
+    PWL_checkMonotonicity(pwl);
+    return pwl;
+}
+
+//value of a row of a table for CONFIG_getPwl(): the key itself if it exists (then that is the only row), "key[row]" otherwise. rowKey needs space for the key plus 12 chars
+static const char * CONFIG_getRow(const Config_t * cfg, const char * key, uint32_t row, char * rowKey){
+    const char * value = CONFIG_get(cfg, key);
+    if(value != NULL) return (row == 0) ? value : NULL;
+    
+    //build "key[row]", the digits of the row number are written backwards into a small buffer first
+    char digits[10];
+    uint32_t digitCount = 0;
+    do{
+        digits[digitCount++] = '0' + row % 10;
+        row /= 10;
+    }while(row > 0);
+    
+    uint32_t length = strlen(key);
+    memcpy(rowKey, key, length);
+    rowKey[length++] = '[';
+    while(digitCount > 0) rowKey[length++] = digits[--digitCount];
+    rowKey[length++] = ']';
+    rowKey[length] = 0;
+    
+    return CONFIG_get(cfg, rowKey);
+}
+
+//strcmp() == 0 but without caring about upper and lower case
+static uint32_t CONFIG_equalsIgnoreCase(const char * a, const char * b){
+    while(*a != 0 && *b != 0){
+        char charA = (*a >= 'A' && *a <= 'Z') ? *a + ('a' - 'A') : *a;
+        char charB = (*b >= 'A' && *b <= 'Z') ? *b + ('a' - 'A') : *b;
+        if(charA != charB) return 0;
+        a++;
+        b++;
+    }
+    
+    return *a == *b;
+}
+
+/*
+ * class of every char (UTIL_CHAR_ flags) and its value in the low byte: the digit for numbers, the exponent for multipliers (f.e. 3 for 'k', 0 for the dot). 
+ * This way the parsers need one load per char instead of a chain of compares, see the predicates in util.h
+ * 
+ *      special characters are everything below 32 and above 127, 230 is the greek micro of the extended ascii table
+ */
+const uint16_t utilCharTable[256] = {
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x1c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0x00 - 0x0f
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0x10 - 0x1f
+    0x1800, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1000, 0x0000, 0x0200, 0x0000,    //0x20 - 0x2f
+    0x0100, 0x0101, 0x0102, 0x0103, 0x0104, 0x0105, 0x0106, 0x0107, 0x0108, 0x0109, 0x0000, 0x1000, 0x0000, 0x0000, 0x0000, 0x0000,    //0x30 - 0x3f
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0209, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0206, 0x0000, 0x0000,    //0x40 - 0x4f
+    0x020f, 0x0000, 0x0000, 0x0000, 0x020c, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,    //0x50 - 0x5f
+    0x0000, 0x0000, 0x0000, 0x02fe, 0x02ff, 0x0000, 0x02f1, 0x0000, 0x0202, 0x0000, 0x0000, 0x0203, 0x0000, 0x02fd, 0x02f7, 0x0000,    //0x60 - 0x6f
+    0x02f4, 0x0000, 0x0000, 0x0000, 0x0000, 0x02fa, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,    //0x70 - 0x7f
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0x80 - 0x8f
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0x90 - 0x9f
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0xa0 - 0xaf
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0xb0 - 0xbf
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0xc0 - 0xcf
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0xd0 - 0xdf
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0efa, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0xe0 - 0xef
+    0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00, 0x0c00,    //0xf0 - 0xff
+};
+
+
+/*
+ * Fixed point atoi function that supports multipliers like k,m,M,c,d etc.
+ * 
+ * input string must start with a number, otherwise 0 is returned. It will scan until either a null terminator is reached or strlen chars have been read
+ * 
+ * ignoreUnit will make the function not return in an error state if the string contains a unit at the end (like for example "1sec")
+ * 
+ *      NOTE: if the returned value would contain an integer overflow due to an excessively large input number a 0 is returned instead
+ *      NOTE: any numbers after the last digit in the fixed point return will be ignored
+ *      NOTE: this is atoiFP_r() without the end pointer and error code, use that if you need to know why a 0 was returned
+ */
+int32_t atoiFP(const char * a, uint32_t strlen, int32_t baseExponent, uint32_t ignoreUnit){
+    return atoiFP_r(a, strlen, baseExponent, ignoreUnit ? ATOIFP_IGNORE_UNIT : 0, NULL, NULL);
+}
+
+/*
+ * Same as atoiFP(), but strtol style: end is set to the first char after the number and err to ATOIFP_OK or one of the ATOIFP_ERROR_ codes. Both can be NULL
+ * 
+ * usage:
+ *      const char * end;
+ *      int err;
+ *      int32_t current_mA = atoiFP_r("2.5A 12V", 0, 3, ATOIFP_IGNORE_UNIT, &end, &err);     //current_mA = 2500, end points to " 12V"
+ * 
+ *      len = 0 scans until the terminator. With ATOIFP_IGNORE_UNIT a unit after the number is skipped as well (it ends at a space, comma, semicolon or tab)
+ *      If there is no number at all end is set to a, after any other error it points to where the problem is
+ * 
+ *      The string is only read once: the digits are collected into a 64 bit mantissa and scaled to the base exponent at the very end
+ * 
+ * returns the number, 0 on any error
+ */
+int32_t atoiFP_r(const char * a, size_t len, int32_t baseExponent, uint32_t flags, const char ** end, int * err){
+    int64_t mantissa = 0;
+    int32_t exponent = 0;
+    uint32_t truncated = 0;
+    int32_t ret = 0;
+    
+    int error = (a != NULL) ? atoiFP_parse(a, len, flags, end, &mantissa, &exponent, &truncated) : ATOIFP_ERROR_NO_NUMBER;
+    if(error == ATOIFP_OK) ret = atoiFP_scale(mantissa, exponent + baseExponent, truncated, &error);
+    
+    if(error != ATOIFP_OK) UTIL_traceEvent(UTIL_TRACE_DEBUG, UTIL_EVENT_ATOIFP_ERROR, error, len);
+    if(err != NULL) *err = error;
+    return ret;
+}
+
+//char i of a string with length len (0 = terminated), 0 after its end
+static inline char atoiFP_peek(const char * a, size_t len, size_t i){
+    return (len == 0 || i < len) ? a[i] : 0;
+}
+
+/*
+ * the forward pass of atoiFP_r(): parses the string into value = mantissa * 10^exponent without caring about any base exponent yet
+ * 
+ * truncated is set if digits had to be dropped because the mantissa already had 18 of them, then it is larger than any int32_t and must not be scaled up anymore
+ */
+static int atoiFP_parse(const char * a, size_t len, uint32_t flags, const char ** end, int64_t * mantissa, int32_t * exponent, uint32_t * truncated){
+    size_t i = 0;
+    uint32_t isNegative = 0;
+    int64_t digits = 0;
+    int32_t digitExponent = 0;
+    char c;
+    
+    *truncated = 0;
+    
+    //skip any leading spaces, a minus inverts the sign of the number and a plus is allowed but doesn't do anything
+    while((c = atoiFP_peek(a, len, i)) == ' ' || c == '-' || c == '+'){
+        if(c == '-') isNegative = !isNegative;
+        i++;
+    }
+    
+    //the number may also start with the dot
+    if(!isAsciiNumber(c) && c != '.'){
+        if(end != NULL) *end = a;
+        return ATOIFP_ERROR_NO_NUMBER;
+    }
+    
+    //digits in front of the point. 18 of them are more than any int32_t can hold, the rest only moves the exponent
+    for(; isAsciiNumber(c = atoiFP_peek(a, len, i)); i++){
+        if(digits < 100000000000000000LL){
+            digits = digits * 10 + UTIL_getCharValue(c);
+        }else{
+            digitExponent++;
+            *truncated = 1;
+        }
+    }
+    
+    //now either a dot or a multiplier can follow ("4.7k" or "4k7"), the digits after that move the exponent the other way
+    uint32_t isDot = (c == '.');
+    uint32_t hasMultiplier = 0;
+    
+    if(isAsciiMultiplier(c)){
+        digitExponent += UTIL_getCharValue(c);
+        hasMultiplier = !isDot;
+        i++;
+        
+        for(; isAsciiNumber(c = atoiFP_peek(a, len, i)); i++){
+            if(digits < 100000000000000000LL){
+                digits = digits * 10 + UTIL_getCharValue(c);
+                digitExponent--;
+            }else{
+                *truncated = 1;
+            }
+        }
+        
+        //after a dot there can still be a multiplier (but not another dot)
+        if(isDot && c != '.' && isAsciiMultiplier(c)){
+            digitExponent += UTIL_getCharValue(c);
+            hasMultiplier = 1;
+            i++;
+            c = atoiFP_peek(a, len, i);
+        }
+    }
+    
+    //an e exponent can follow the digits if there was no multiplier ("1.5e-3")
+    if(!hasMultiplier && (c == 'e' || c == 'E')){
+        char sign = atoiFP_peek(a, len, i + 1);
+        size_t start = (sign == '-' || sign == '+') ? i + 2 : i + 1;
+        
+        //only if there is a number after it, otherwise the e is the start of the unit
+        if(isAsciiNumber(atoiFP_peek(a, len, start))){
+            int32_t e = 0;
+            for(i = start; isAsciiNumber(c = atoiFP_peek(a, len, i)); i++){
+                if(e < 1000) e = e * 10 + UTIL_getCharValue(c);
+            }
+            digitExponent += (sign == '-') ? -e : e;
+        }
+    }
+    
+    //anything else up to the next separator is a unit
+    size_t unitEnd = i;
+    while((c = atoiFP_peek(a, len, unitEnd)) != 0 && !isListSeparator(c)) unitEnd++;
+    
+    if(unitEnd > i){
+        if(!(flags & ATOIFP_IGNORE_UNIT)){
+            if(end != NULL) *end = &a[i];
+            return ATOIFP_ERROR_UNIT;
+        }
+        i = unitEnd;
+    }
+    
+    //keep the exponent in a range that can't overflow once the base exponent is added
+    if(digitExponent > 1000) digitExponent = 1000;
+    if(digitExponent < -1000) digitExponent = -1000;
+    
+    if(end != NULL) *end = &a[i];
+    *mantissa = isNegative ? -digits : digits;
+    *exponent = digitExponent;
+    return ATOIFP_OK;
+}
+
+/*
+ * the scaling of atoiFP_r(): mantissa * 10^exponent, digits below 10^0 are cut off. Sets err (if not NULL) to ATOIFP_ERROR_OVERFLOW and returns 0 if the result doesn't fit into an int32_t
+ */
+static int32_t atoiFP_scale(int64_t mantissa, int32_t exponent, uint32_t truncated, int * err){
+    static const uint64_t powersOfTen[19] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL, 
+        10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 
+        10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL
+    };
+    
+    //work with the magnitude, a negative number can go one further than a positive one
+    uint64_t magnitude = (mantissa < 0) ? -(uint64_t) mantissa : (uint64_t) mantissa;
+    uint64_t limit = (mantissa < 0) ? (uint64_t) INT32_MAX + 1 : INT32_MAX;
+    
+    if(magnitude == 0) return 0;
+    
+    if(exponent < 0){
+        magnitude = (exponent < -18) ? 0 : magnitude / powersOfTen[-exponent];
+        
+    }else if(exponent > 0){
+        //a truncated mantissa is too large already, scaling it up would also make the dropped digits part of the result
+        if(truncated || exponent > 18 || magnitude > limit / powersOfTen[exponent]){
+            if(err != NULL) *err = ATOIFP_ERROR_OVERFLOW;
+            return 0;
+        }
+        magnitude *= powersOfTen[exponent];
+    }
+    
+    if(magnitude > limit){
+        if(err != NULL) *err = ATOIFP_ERROR_OVERFLOW;
+        return 0;
+    }
+    
+    return (mantissa < 0) ? (int32_t) -(int64_t) magnitude : (int32_t) magnitude;
+}
+
+/*
+ * Converts a whole list of fixed point numbers (f.e. "1k, 2.2k, 4.7k") with atoiFP(), in one pass over the string
+ * 
+ * usage:
+ *      int32_t values[8];
+ *      const int32_t exponent = 0;
+ *      const char * end;
+ *      uint32_t count = atoiFPList("1k, 2.2k, 4.7k", values, 8, &exponent, 1, ATOIFP_IGNORE_UNIT, &end, NULL);
+ * 
+ *      the numbers can be separated by spaces, commas, semicolons or tabs. Value i is converted with baseExponents[i % exponentCount], 
+ *      so f.e. {xExponent, yExponent} converts a list of x/y pairs. flags are the ones of atoiFP_r(), with ATOIFP_IGNORE_UNIT units after a number are ignored
+ * 
+ *      The list ends at the end of the string, after maxCount values or at the first item that doesn't start with a number or can't be converted. 
+ *      end (if not NULL) is set to the first char that wasn't used, so it points to the terminator if the whole list was converted and a call with end as the string continues the list.
+ *      err (if not NULL) is set to ATOIFP_OK if the list ended at the terminator or after maxCount values, otherwise to the ATOIFP_ERROR_ code of the item it stopped at
+ * 
+ *      values can be NULL, then the numbers are only checked and counted
+ * 
+ * returns the number of values converted
+ */
+uint32_t atoiFPList(const char * a, int32_t * values, uint32_t maxCount, const int32_t * baseExponents, uint32_t exponentCount, uint32_t flags, const char ** end, int * err){
+    uint32_t count = 0;
+    int error = ATOIFP_OK;
+    
+    if(a == NULL || baseExponents == NULL || exponentCount == 0){
+        error = ATOIFP_ERROR_NO_NUMBER;
+    }else{
+        while(isListSeparator(*a)) a++;
+        
+        while(count < maxCount && *a != 0){
+            //does the next item even look like a number?
+            if(!isAsciiNumber(*a) && *a != '.' && *a != '-' && *a != '+'){
+                error = ATOIFP_ERROR_NO_NUMBER;
+                break;
+            }
+            
+            uint32_t length = 0;
+            while(a[length] != 0 && !isListSeparator(a[length])) length++;
+            
+            //stop at an item that isn't a valid number, end then points to it
+            int32_t value = atoiFP_r(a, length, baseExponents[count % exponentCount], flags, NULL, &error);
+            if(error != ATOIFP_OK) break;
+            
+            if(values != NULL) values[count] = value;
+            count++;
+            
+            //skip the separators too, that way end is at the terminator after the last number
+            a += length;
+            while(isListSeparator(*a)) a++;
+        }
+    }
+    
+    if(end != NULL) *end = a;
+    if(err != NULL) *err = error;
+    return count;
+}
+
+//chars that separate the values of a list for atoiFPList()
+static inline uint32_t isListSeparator(char c){
+    return (utilCharTable[(uint8_t) c] & UTIL_CHAR_SEPARATOR) != 0;
+}
+
+//digit pairs "00" to "99" for itoaFP()
+static const char itoaFPDigitPairs[200] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static const uint32_t itoaFPPowersOfTen[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+/*
+ * Fixed point to string conversion with SI prefixes, the counterpart of atoiFP(): the number is value * 10^-baseExponent, so atoiFP() of the string with the same baseExponent returns value again
+ * 
+ * usage:
+ *      char buffer[16];
+ *      itoaFP(25400, 3, buffer, sizeof(buffer), ITOAFP_DIGITS(3));     //"25.4"
+ *      itoaFP(4700000, 3, buffer, sizeof(buffer), ITOAFP_DIGITS(2));   //"4.7k"
+ *      itoaFP(-1250, 6, buffer, sizeof(buffer), 0);                    //"-1.25m"
+ * 
+ *      flags: ITOAFP_DIGITS(n) rounds the number to n significant digits (up to 9) and always prints all of them (f.e. "2.50k"), 
+ *      without it every digit of value is printed but trailing zeros after the point are dropped. ITOAFP_NO_PREFIX prints the plain decimal number instead of using an SI prefix
  * 
- *      To perform the conversion pass the generated PWL to the PWL_getY() function together with the resistance in Ohms. preComputedDerivative must be set to 1
+ *      The digits are created two at a time with a lookup table, so there is only one division by 100 per two digits and no float anywhere
+ * 
+ * returns the length of the string (without the terminator), 0 if buf is too small (buf is then an empty string)
  */
-Pwl_t * NTC_generatePWL(NTC_Coefficients_t * coefficients, int32_t startTemperature, int32_t endTemperature, uint32_t pointCount, NTC_TemperatureUnit_t unit){
-//are the parameters valid?
-    if(startTemperature >= endTemperature || pointCount < 2 || coefficients == NULL) return NULL;
-    
-//create a new PWL. Just return if that doesn't work
-    Pwl_t * pwl = PWL_create(NULL, pointCount, 1, 1);
-    if(pwl == NULL) return NULL;
-    
-//calculate start and end resistance values. The end value is the one matching the start temperature as we need to sort by ascending resistance
+uint32_t itoaFP(int32_t value, int32_t baseExponent, char * buf, size_t len, uint32_t flags){
+    static const char prefixes[] = {'f', 'p', 'n', 'u', 'm', 0, 'k', 'M', 'G', 'T', 'P'};
     
-    float startResistance = NTC_getResistanceAtTemperature(coefficients, endTemperature, unit);
-    float endResistance = NTC_getResistanceAtTemperature(coefficients, startTemperature, unit);
-    float resistanceStep = ((float) endResistance - (float) startResistance) / (float) pointCount;
+    if(buf == NULL || len == 0) return 0;
     
-    //step through each list entry and calculate the temperature corresponding to the resistance
-    //for reference: PWL format with preComputedDerivative=1 is {xValue,yValue,dY/dX}
+    //work with the magnitude, that way INT32_MIN works too
+    uint32_t isNegative = value < 0;
+    uint32_t mantissa = isNegative ? -(uint32_t) value : (uint32_t) value;
+    int32_t exponent = -baseExponent;
     
-    float currentResistance = startResistance;
-    int32_t * lastRow = NULL;
+    uint32_t digitCount = itoaFP_countDigits(mantissa);
+    uint32_t significantDigits = flags & ITOAFP_DIGITS_MASK;
+    if(significantDigits > 9) significantDigits = 9;
     
-    for(int32_t i = 0; i < pointCount; i++){
-        //generate a pointer to the current row
-        int32_t * currentRow = &(pwl->data[i * 3]);
+    if(mantissa == 0){
+        //zero has no exponent to pick a prefix by
+        exponent = 0;
         
-        //first row entry is the x value (in our case the resistance)
-        currentRow[0] = (int32_t) currentResistance;
+    }else if(significantDigits == 0){
+        //all digits, but without the trailing zeros
+        while(mantissa % 10 == 0){
+            mantissa /= 10;
+            exponent++;
+            digitCount--;
+        }
         
-        //second row entry is the resulting y value (aka the temperature, converted into the desired unit)
-        currentRow[1] = NTC_getTemperatureAtResistance(coefficients, currentResistance, unit);
+    }else if(digitCount > significantDigits){
+        //round to the number of digits we want
+        uint32_t drop = digitCount - significantDigits;
+        uint32_t divisor = itoaFPPowersOfTen[drop];
+        uint32_t quotient = mantissa / divisor;
+        if(mantissa - quotient * divisor >= divisor / 2) quotient++;
         
-        //third row entry is the derivative between this point and the last
-        //this is always calculated for the last entry instead of the current one, so we skip this for the first entry
-        //we don't need to add a derivative for the very last row of the PWL as it is never used
-        if(i != 0){
-            //derivativce is dy/dx
-            int32_t dy = (currentRow[1] - lastRow[1]) * 256;
-            int32_t dx = currentRow[0] - lastRow[0];
-            if(dx != 0) lastRow[2] = dy / dx; else lastRow[2] = 0;
+        mantissa = quotient;
+        exponent += drop;
+        
+        //rounding up might have added a digit (f.e. 9.99 -> 10.0)
+        if(mantissa == itoaFPPowersOfTen[significantDigits]){
+            mantissa /= 10;
+            exponent++;
         }
+        digitCount = significantDigits;
         
-        lastRow = currentRow;
-        currentResistance += resistanceStep;
+    }else{
+        //pad with zeros to get the number of digits we want
+        mantissa *= itoaFPPowersOfTen[significantDigits - digitCount];
+        exponent -= significantDigits - digitCount;
+        digitCount = significantDigits;
     }
     
-    return pwl;
-}
-
-float NTC_getResistanceAtTemperature(NTC_Coefficients_t * coefficients, int32_t temperature, NTC_TemperatureUnit_t unit){
-    //convert temperature to Kelvin
-    float t1_K = NTC_unitToKelvin(temperature, unit);
+    //decimal exponent of the first digit decides about the prefix, the point is then placed after 1 to 3 digits
+    int32_t leadingExponent = exponent + (int32_t) digitCount - 1;
+    int32_t prefixExponent = 0;
     
-    //calculate Resistance according to Beta formula
-    // R1 = R0 * exp(Beta * (1/T1 - 1/T0))
-    return coefficients->R0 * exp(coefficients->Beta * ((1/t1_K) - (1/coefficients->T0)));
-}
-
-int32_t NTC_getTemperatureAtResistance(NTC_Coefficients_t * coefficients, float resistance, NTC_TemperatureUnit_t unit){
-    //use the Beta formula to calculate the temperature
-    float temperature_K = 1.0 / ( (log(resistance / coefficients->R0) / coefficients->Beta ) + 1.0 / coefficients->T0);
+    if(!(flags & ITOAFP_NO_PREFIX) && mantissa != 0){
+        prefixExponent = (leadingExponent >= 0) ? (leadingExponent / 3) * 3 : -((-leadingExponent + 2) / 3) * 3;
+        if(prefixExponent > 15) prefixExponent = 15;
+        if(prefixExponent < -15) prefixExponent = -15;
+    }
+    char prefix = prefixes[(prefixExponent + 15) / 3];
     
-    //return the value after converting to the desired unit
-    return NTC_kelvinToUnit(temperature_K, unit);
+    //digits in front of the point, can be more than the mantissa has (then zeros follow) or none at all (then zeros come after the point first)
+    int32_t integerDigits = leadingExponent - prefixExponent + 1;
+    
+    //check that everything fits before writing anything
+    uint32_t length = isNegative + (prefix != 0);
+    if(integerDigits <= 0){
+        length += 2 - integerDigits + digitCount;
+    }else{
+        length += ((uint32_t) integerDigits > digitCount) ? (uint32_t) integerDigits : digitCount + ((uint32_t) integerDigits < digitCount);
+    }
+    
+    if(length >= len){
+        buf[0] = 0;
+        return 0;
+    }
+    
+    char digits[10];
+    itoaFP_writeDigits(mantissa, digits, digitCount);
+    
+    char * out = buf;
+    if(isNegative) *out++ = '-';
+    
+    if(integerDigits <= 0){
+        *out++ = '0';
+        *out++ = '.';
+        for(int32_t i = integerDigits; i < 0; i++) *out++ = '0';
+        memcpy(out, digits, digitCount);
+        out += digitCount;
+        
+    }else if((uint32_t) integerDigits >= digitCount){
+        memcpy(out, digits, digitCount);
+        out += digitCount;
+        for(uint32_t i = digitCount; i < (uint32_t) integerDigits; i++) *out++ = '0';
+        
+    }else{
+        memcpy(out, digits, integerDigits);
+        out += integerDigits;
+        *out++ = '.';
+        memcpy(out, &digits[integerDigits], digitCount - integerDigits);
+        out += digitCount - integerDigits;
+    }
+    
+    if(prefix != 0) *out++ = prefix;
+    *out = 0;
+    
+    return out - buf;
 }
 
-static int32_t NTC_kelvinToUnit(float temperature_K, NTC_TemperatureUnit_t unit){
-    switch(unit){
-        case NTC_MILLI_KELVIN:
-            return (int32_t) (temperature_K * 1000.0);
-            
-        case NTC_MILLI_DEG_CELSIUS:
-            return (int32_t) ((temperature_K - 273.15) * 1000.0);
-            
-        //TODO: implement conversion to Fahrenheit
-            
-        default: 
-            return 0;
-    }
+//number of decimal digits of x, at least one
+static inline uint32_t itoaFP_countDigits(uint32_t x){
+    uint32_t count = 1;
+    while(count < 10 && x >= itoaFPPowersOfTen[count]) count++;
+    return count;
 }
 
-static float NTC_unitToKelvin(int32_t temperature, NTC_TemperatureUnit_t unit){
-    //convert from a temperature value with specified unit to Kelvin
-    switch(unit){
-        case NTC_MILLI_KELVIN:
-            return (float) temperature / 1000.0;
-            
-        case NTC_MILLI_DEG_CELSIUS:
-            return ((float) temperature / 1000.0) + 273.15;
-            
-        //TODO: implement conversion from Fahrenheit
-            
-        default: 
-            return 0;
+//writes the count lowest decimal digits of x into digits (not terminated), starting at the back two at a time
+static void itoaFP_writeDigits(uint32_t x, char * digits, uint32_t count){
+    while(count >= 2){
+        uint32_t quotient = x / 100;
+        uint32_t pair = x - quotient * 100;
+        count -= 2;
+        digits[count] = itoaFPDigitPairs[pair * 2];
+        digits[count + 1] = itoaFPDigitPairs[pair * 2 + 1];
+        x = quotient;
     }
+    
+    if(count == 1) digits[0] = '0' + x % 10;
 }
 
 
@@ -297,618 +3732,481 @@ static float NTC_unitToKelvin(int32_t temperature, NTC_TemperatureUnit_t unit){
 
 
 
+/*
+ * LUT based fast sine function
+ * 
+ * parameter is a variable between 0-512 with 512 = 2pi. Return value is -500000 to 500000
+ * 
+ *      NOTE: this is qSin32() scaled to the old range, use that one directly for anything new
+ */
+int32_t qSin(int32_t x){
+    //512 = 2pi is 2^9, the phase of qSin32() is 2^32. Any multiple of the period just falls off the top
+    int64_t y = (int64_t) qSin32((uint32_t) x << 23) * 500000;
+    return (int32_t) ((y + (1 << 29)) >> 30);
+}
+
+//129 value sin lookup table x := [0, pi/2] in Q30, the other three quarters are mirrored from it
+static const int32_t quarterSineTable[QSIN_TABLE_SIZE + 1] = {
+    0, 13176464, 26350943, 39521455, 52686014, 65842639, 78989349, 92124163,
+    105245103, 118350194, 131437462, 144504935, 157550647, 170572633, 183568930, 196537583,
+    209476638, 222384147, 235258165, 248096755, 260897982, 273659918, 286380643, 299058239,
+    311690799, 324276419, 336813204, 349299266, 361732726, 374111709, 386434353, 398698801,
+    410903207, 423045732, 435124548, 447137835, 459083786, 470960600, 482766489, 494499676,
+    506158392, 517740883, 529245404, 540670223, 552013618, 563273883, 574449320, 585538248,
+    596538995, 607449906, 618269338, 628995660, 639627258, 650162530, 660599890, 670937767,
+    681174602, 691308855, 701339000, 711263525, 721080937, 730789757, 740388522, 749875788,
+    759250125, 768510122, 777654384, 786681534, 795590213, 804379079, 813046808, 821592095,
+    830013654, 838310216, 846480531, 854523370, 862437520, 870221790, 877875009, 885396022,
+    892783698, 900036924, 907154608, 914135678, 920979082, 927683790, 934248793, 940673101,
+    946955747, 953095785, 959092290, 964944360, 970651112, 976211688, 981625251, 986890984,
+    992008094, 996975812, 1001793390, 1006460100, 1010975242, 1015338134, 1019548121, 1023604567,
+    1027506862, 1031254418, 1034846671, 1038283080, 1041563127, 1044686319, 1047652185, 1050460278,
+    1053110176, 1055601479, 1057933813, 1060106826, 1062120190, 1063973603, 1065666786, 1067199483,
+    1068571464, 1069782521, 1070832474, 1071721163, 1072448455, 1073014240, 1073418433, 1073660973,
+    1073741824
+};
 
+/*
+ * Quarter wave LUT sine with linear interpolation
+ * 
+ * usage: phase is a uint32_t with 2^32 = 2pi, so a phase accumulator just overflows at the end of a period. Return value is Q30 (QSIN_ONE = 1.0)
+ * 
+ *      the table has QSIN_TABLE_SIZE segments per quarter wave, the interpolation keeps the error below 2e-5 (about -94dB)
+ */
+int32_t qSin32(uint32_t phase){
+    return qSinQuarter(phase);
+}
 
+//same as qSin32() but cos, which is just sin a quarter of a period later
+int32_t qCos32(uint32_t phase){
+    return qSinQuarter(phase + (1UL << 30));
+}
 
+//sin and cos of the same phase, f.e. for a park transformation
+void qSinCos32(uint32_t phase, int32_t * sine, int32_t * cosine){
+    if(sine != NULL) *sine = qSinQuarter(phase);
+    if(cosine != NULL) *cosine = qSinQuarter(phase + (1UL << 30));
+}
 
+static inline int32_t qSinQuarter(uint32_t phase){
+    //the top two bits are the quadrant. In the second and fourth the quarter wave runs backwards (~ instead of negating is just 2^-32 of a period off)
+    uint32_t quadrant = phase >> 30;
+    uint32_t x = (quadrant & 1) ? ~phase : phase;
+    x &= (1UL << 30) - 1;
+    
+    //upper bits select the segment, the lower ones are the position in it
+    uint32_t index = x >> QSIN_FRACTION_BITS;
+    int32_t fraction = x & ((1UL << QSIN_FRACTION_BITS) - 1);
+    
+    int32_t y0 = quarterSineTable[index];
+    int32_t y = y0 + (int32_t) (((int64_t) (quarterSineTable[index + 1] - y0) * fraction + (1 << (QSIN_FRACTION_BITS - 1))) >> QSIN_FRACTION_BITS);
+    
+    //the second half of the period is negative
+    return (quadrant & 2) ? -y : y;
+}
 
 /*
- * Config file tool. Looks through a given file and finds the first line that contains a definition of it
+ * Phase accumulator oscillator (DDS) for filling whole DMA buffers of a PWM or DAC with a sine at once
  * 
- * Line format: 
- *      //a very nice comment, as long as it contains "//" as the first two non space characters
- *      aVeryNiceKeyName = a very nice value with spaces that ends with a newline char //a comment after this is also possible :)
+ * usage:
+ *      qOsc_t osc;
+ *      qOsc_init(&osc, QOSC_PHASE_STEP(50, 20000), 3, 512);      //50Hz at 20kHz sample rate, three phases around 512
+ *      ...
+ *      //in the DMA half transfer interrupt: 64 frames of three samples each (a, b, c, a, b, c, ...), amplitude ramps to 400 over the block
+ *      qOsc_fill(&osc, &dmaBuffer[half], 64, 400);
  * 
- *      WARNING: maximum line length given by CONFIG_MAX_LINE_SIZE, entries that are longer will be ignored
- *      WARNING: maximum line count given by CONFIG_MAX_LINE_COUNT, no more lines will be read
- *      NOTE: value will be trimmed of leading and lagging spaces
+ *      phaseCount is 1 for a single sine or 3 for three phases 120deg apart, interleaved in the buffer. buf must hold n * phaseCount values
+ *      sample = offset + amplitude * sin(phase), so amplitudeQ is in whatever unit the output is (f.e. PWM counts or a Q format)
+ * 
+ *      amplitude and frequency never jump: amplitude ramps linearly from the last one to amplitudeQ over each block, 
+ *      a frequency set with qOsc_setFrequency() is reached at the end of the next block the same way. The step from the last sample of a block
+ *      to the first one of the next is the same as the one between any two samples of the ramp (within one count)
  */
+void qOsc_init(qOsc_t * osc, uint32_t phaseStep, uint32_t phaseCount, int32_t offset){
+    if(osc == NULL) return;
+    
+    osc->phase = 0;
+    osc->phaseStep = phaseStep;
+    osc->targetPhaseStep = phaseStep;
+    osc->amplitude = 0;
+    osc->offset = offset;
+    osc->phaseCount = (phaseCount == 3) ? 3 : 1;
+}
 
-#if __has_include("ff.h")
-char * CONFIG_getKey(FIL * file, char * keyToFind){
-    //check if the file is value
-    if(file < 0xff){
-        //no its not, either NULL or an error code. Just return
-        return NULL;
-    }
+//sets the frequency the oscillator ramps to during the next qOsc_fill(), see QOSC_PHASE_STEP()
+void qOsc_setFrequency(qOsc_t * osc, uint32_t phaseStep){
+    if(osc == NULL) return;
+    osc->targetPhaseStep = phaseStep;
+}
+
+/*
+ * generates the next n frames of the oscillator, see qOsc_init()
+ * 
+ * returns the number of values written (n * phaseCount)
+ */
+uint32_t qOsc_fill(qOsc_t * osc, int32_t * buf, size_t n, int32_t amplitudeQ){
+    if(osc == NULL || buf == NULL || n == 0) return 0;
     
-    //file is valid, seek to the beginning
-    FRESULT seekRes = f_lseek(file, 0);
-    if(seekRes != FR_OK) TERM_printDebug(TERM_handle, "seek failed (%d)", seekRes);
+    //everything that changes per sample lives in locals so it can stay in registers
+    uint32_t phase = osc->phase;
+    int32_t offset = osc->offset;
     
-    uint32_t rowsRead = 0;
-    char * rowBuffer = pvPortMalloc(CONFIG_MAX_LINE_SIZE * sizeof(char));
-    if(rowBuffer == NULL) return NULL;  //no space available for row buffer
+    //the ramps over this block are done in Q16, so the n steps add up to the whole difference instead of leaving the remainder of the division as a jump at the end.
+    //Setting the targets after the last sample then moves them by less than one count. The half count added at the start makes the >> 16 round instead of truncating
+    int64_t phaseStep = (int64_t) osc->phaseStep * 65536 + 32768;
+    int64_t amplitude = (int64_t) osc->amplitude * 65536 + 32768;
+    int64_t phaseStepDelta = ((int64_t) osc->targetPhaseStep - osc->phaseStep) * 65536 / (int64_t) n;
+    int64_t amplitudeDelta = ((int64_t) amplitudeQ - osc->amplitude) * 65536 / (int64_t) n;
     
-    //go through the file
-    while(rowsRead < CONFIG_MAX_LINE_COUNT){
-        //read a line
-        uint32_t bytesRead = f_gets(rowBuffer, CONFIG_MAX_LINE_SIZE * sizeof(char), file);
-        
-        //did it work?
-        if(bytesRead == 0){
-            //no, some error occurred before we found the key, just return null after cleaning up
-            //TERM_printDebug(TERM_handle, "didn't manage to read even one byte :( ");
-            
-            //free the row buffer
-            vPortFree(rowBuffer);        
-            return NULL;
-            
-        }else if(bytesRead == CONFIG_MAX_LINE_SIZE * sizeof(char)){
-            //we came across a line too big to fit our buffer, try to find the end of this line so we can skip it properly
-            while((bytesRead = f_gets(rowBuffer, CONFIG_MAX_LINE_SIZE * sizeof(char), file))){ 
-                if(bytesRead < CONFIG_MAX_LINE_SIZE * sizeof(char)) break;
-                //TODO check if we somehow overran the buffer
-            }
-            //TERM_printDebug(TERM_handle, "line[%d] was too large an skipped ", rowsRead);
-            
-            //continue scanning the next line
-            rowsRead++;
-            continue;
+    size_t i = 0;
+    if(osc->phaseCount == 3){
+        for(; i < n; i++){
+            int32_t currentAmplitude = (int32_t) (amplitude >> 16);
+            buf[0] = qOsc_getSample(phase, currentAmplitude, offset);
+            buf[1] = qOsc_getSample(phase - QOSC_THIRD_PERIOD, currentAmplitude, offset);
+            buf[2] = qOsc_getSample(phase - 2 * QOSC_THIRD_PERIOD, currentAmplitude, offset);
+            buf += 3;
             
-        }else if(bytesRead > CONFIG_MAX_LINE_SIZE * sizeof(char)){
-            //we overran the buffer!! code is now in an instable state, reboot is unfortunately the only option now
-            //TODO
-            while(1);   //wait for reboot
-        }else if(bytesRead <= 2){
-            //empty line :) just skip it
-            continue;
+            phase += (uint32_t) (phaseStep >> 16);
+            phaseStep += phaseStepDelta;
+            amplitude += amplitudeDelta;
         }
         
-        //TERM_printDebug(TERM_handle, "got line[%d] with length %d: \"%s\" ", rowsRead, bytesRead, rowBuffer);
-        
-        enum {key_trimLeadingSpaces, key_findEnd, equalSign_find, value_trimLeadingSpaces, value_findEnd} state = key_trimLeadingSpaces;
-        
-        //check the current line for two patterns: "//" and "="
-        uint32_t consequitiveslashCount = 0;
-        
-        char * key = NULL;
-        uint32_t keyEndFound = 0;
-        
-        uint32_t equalSignFound = 0;
-        
-        char * value = NULL;
-        char * currentEndOfValue = NULL;
-        char * currentEndOfValueBeforeCommentSequence = NULL;
-        uint32_t wasWaitingForValueBeforeCommentSequence = 0;
-        
-        for(uint32_t currChar = 0; currChar < bytesRead-1; currChar++){
-            //check what letter we are scanning
-            
-            //TERM_printDebug(TERM_handle, "\tscanning letter '%c' (%02x) ", rowBuffer[currChar], rowBuffer[currChar]);
-            
-            //are we at the end of the string?
-            if(rowBuffer[currChar] == 0) break; //yes => exit loop
-            
-            //check if we have run across a comment sequence ("//")
-            if(rowBuffer[currChar] == '/'){
-                //yes, now check if the previous char was a / as well
-                if(consequitiveslashCount == 1){
-                    //yes, we just scanned across a comment start sequence. 
-                    
-                    //TERM_printDebug(TERM_handle, "\t\tend of command sequence ");
-                    
-                    if(currentEndOfValueBeforeCommentSequence != NULL){ 
-                        currentEndOfValue = currentEndOfValueBeforeCommentSequence;
-                        //TERM_printDebug(TERM_handle, "\t\twe were waiting for a non space char before this comment sequence ");
-                    }
-                    
-                    if(wasWaitingForValueBeforeCommentSequence){
-                        value = NULL;
-                        state = value_trimLeadingSpaces;
-                        //TERM_printDebug(TERM_handle, "\t\twe were waiting for a non space char after equal sign before this comment sequence ");
-                    }
-                    
-                    //cut the string off before the comment sequence and stop scanning
-                    rowBuffer[currChar-1] = 0;
-                    break;
-                }else{
-                    //TERM_printDebug(TERM_handle, "\t\tstart of command sequence ");
-                    consequitiveslashCount++;   //keep track of how many slashes in a row we found
-                    
-                    if(currentEndOfValue != NULL) currentEndOfValueBeforeCommentSequence = currentEndOfValue;
-                    if(state == value_trimLeadingSpaces) wasWaitingForValueBeforeCommentSequence = 1;
-                }
-            }else{
-                consequitiveslashCount = 0;
-                wasWaitingForValueBeforeCommentSequence = 0;
-                currentEndOfValueBeforeCommentSequence = NULL;
-            }
+    }else{
+        //four samples per loop, that saves most of the loop overhead
+        for(; i + 4 <= n; i += 4){
+            buf[i] = qOsc_getSample(phase, (int32_t) (amplitude >> 16), offset);
+            phase += (uint32_t) (phaseStep >> 16);
+            phaseStep += phaseStepDelta;
+            amplitude += amplitudeDelta;
             
-            //run detection statemachine
-            switch(state){
-                case key_trimLeadingSpaces:
-                    //we haven't run across any non space characters so far, check if this is one
-                    if(rowBuffer[currChar] != ' ' && !isAsciiSpecialCharacter(rowBuffer[currChar])){
-                        //yay start of potential key found :)
-                        
-                        //now make sure this isn't the key-to-value seperator already
-                        if(rowBuffer[currChar] == '='){
-                            //hmmm it is, that means no key was found and we may as well stop analysing this line
-                            //TERM_printDebug(TERM_handle, "\t\tfirst non space char after start of string, but its '=' so skipping this line ");
-                            currChar = bytesRead; //set current pointer to something outside the bounds of the array
-                            break;
-                        }
-                        
-                        //TERM_printDebug(TERM_handle, "\t\tfirst non space char after start of string ");
-                        
-                        //yep a valid first char of the key, note down the position
-                        key = &rowBuffer[currChar];
-                        
-                        //switch to next state: finding the end of the key (first non letter char or the equal sign)
-                        state = key_findEnd;
-                    }
-                    break;
-                    
-                case key_findEnd:
-                    //is this a space that would signal the end of the key?
-                    if(isAsciiSpecialCharacter(rowBuffer[currChar]) || rowBuffer[currChar] == ' '){
-                        //TERM_printDebug(TERM_handle, "\t\tfirst non letter after start of key ");
-                        //yes :) add a string terminator here
-                        rowBuffer[currChar] = 0;
-                        
-                        //switch to next state: finding the equal sign
-                        state = equalSign_find;
-                    }else if(rowBuffer[currChar] == '='){
-                        //TERM_printDebug(TERM_handle, "\t\tfirst non letter after start of key and an equal sign too ");
-                        //oh wow already found the equal sign, that also marks the end of the key string
-                        rowBuffer[currChar] = 0;
-                        
-                        //skip next state and go straight to finding the start of the value string
-                        state = value_trimLeadingSpaces;
-                    }
-                    break;
-                    
-                case equalSign_find:
-                    if(rowBuffer[currChar] == '='){
-                        //TERM_printDebug(TERM_handle, "\t\tequal sign too ");
-                        //found the equal sign
-                        
-                        //switch to next state: finding the start of the value string
-                        state = value_trimLeadingSpaces;
-                    }
-                    break;
-                    
-                case value_trimLeadingSpaces:
-                    //we haven't run across any non space characters after the equal sign so far, check if this is one
-                    if(rowBuffer[currChar] != ' ' && !isAsciiSpecialCharacter(rowBuffer[currChar])){
-                        //TERM_printDebug(TERM_handle, "\t\tfirst non space char after equal sign, start of value ");
-                        //yay start of potential value string found :)
-                        
-                        //note down the position
-                        value = &rowBuffer[currChar];
-                        
-                        //switch to next state: finding the end of the key (first non letter char or the equal sign)
-                        state = value_findEnd;
-                    }
-                    break;
-                    
-                case value_findEnd:
-                    //is this a space that we might need to trim?
-                    
-                    if(isAsciiSpecialCharacter(rowBuffer[currChar]) || rowBuffer[currChar] == ' '){
-                        //yes, check if we have already got a potential candidate for the end of the value string
-                        if(currentEndOfValue == NULL){
-                            //TERM_printDebug(TERM_handle, "\t\tpotential first space after value string ");
-                            
-                            //no, no candidate exists. That means we are a suspect (pretty sus if you ask me)
-                            currentEndOfValue = &rowBuffer[currChar];
-                        }else; //there is already another candidate. Aka no non-space char was scanned since entering the current space region 
-                        
-                    }else{
-                        //ah we got a non space char, reset the potential end of the buffer
-                        if(currentEndOfValue != NULL){
-                            currentEndOfValue = NULL;
-                            //TERM_printDebug(TERM_handle, "\t\tnope*d ");
-                        }
-                    }
-                    break;
-            }
-        }
-        
-        //row scanning statemachine has exited, see how far it got
-        if(state == value_findEnd){
-            //is there a trailing space char we need to trim?
-            if(currentEndOfValue != NULL) *currentEndOfValue = 0; //yes, make a terminator out of it (t800 should do fine for now, might upgrade to 1000 in the future/past)
-                
-            //got all the way through to the end, so a potential key and value pair exists in the buffer now
-            //TERM_printDebug(TERM_handle, "\tstate machine got all the way through :D ");
-            //TERM_printDebug(TERM_handle, "\t\t key=\"%s\" value=\"%s\" ", key, value);
+            buf[i + 1] = qOsc_getSample(phase, (int32_t) (amplitude >> 16), offset);
+            phase += (uint32_t) (phaseStep >> 16);
+            phaseStep += phaseStepDelta;
+            amplitude += amplitudeDelta;
             
-            //now check if the key matches the one we are looking for
-            if(strcmp(keyToFind, key) == 0){
-                //yes we found it!! :D now transfer the value string into its own buffer and return it
-                
-                //create and copy to new buffer
-                char * ret = pvPortMalloc(strlen(value)+1);
-                strcpy(ret, value);
-                vPortFree(rowBuffer);
-                
-                TERM_printDebug(TERM_handle, "key matches! final value return=\"%s\" ", ret);
-                return ret;
-            }
+            buf[i + 2] = qOsc_getSample(phase, (int32_t) (amplitude >> 16), offset);
+            phase += (uint32_t) (phaseStep >> 16);
+            phaseStep += phaseStepDelta;
+            amplitude += amplitudeDelta;
+            
+            buf[i + 3] = qOsc_getSample(phase, (int32_t) (amplitude >> 16), offset);
+            phase += (uint32_t) (phaseStep >> 16);
+            phaseStep += phaseStepDelta;
+            amplitude += amplitudeDelta;
         }
-                
-        //TERM_printDebug(TERM_handle, "row wasn't what we hoped :( \r\n\n\n\n");
         
-        rowsRead++;
+        for(; i < n; i++){
+            buf[i] = qOsc_getSample(phase, (int32_t) (amplitude >> 16), offset);
+            phase += (uint32_t) (phaseStep >> 16);
+            phaseStep += phaseStepDelta;
+            amplitude += amplitudeDelta;
+        }
     }
     
-    //TERM_printDebug(TERM_handle, "scanned %d rows and didn't find the key :(\r\n", rowsRead);
-        
-    //free the row buffer
-    vPortFree(rowBuffer);   
-    return NULL;
-}
-#endif
-
-uint32_t isAsciiSpecialCharacter(char c){
-    if(c < 32) return 1;
-    if(c > 127) return 1;
-    return 0;
+    osc->phase = phase;
+    osc->phaseStep = osc->targetPhaseStep;
+    osc->amplitude = amplitudeQ;
+    
+    return n * osc->phaseCount;
 }
 
-uint32_t isAsciiNumber(char c){
-    if(c >= '0' && c <= '9') return 1;
-    return 0;
+//one output value of an oscillator
+static inline int32_t qOsc_getSample(uint32_t phase, int32_t amplitude, int32_t offset){
+    return offset + (int32_t) (((int64_t) qSinQuarter(phase) * amplitude + (1 << 29)) >> 30);
 }
 
-
-
-
-
+//atan(2^-i) for every CORDIC iteration, in the phase format of qSin32() (2^32 = 2pi)
+static const uint32_t cordicAngleTable[QCORDIC_ITERATIONS] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245, 
+    2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861, 
+    10430, 5215, 2608, 1304, 652, 326, 163, 81
+};
 
 /*
- * Fixed point atoi function that supports multipliers like k,m,M,c,d etc.
- * 
- * input string must start with a number, otherwise 0 is returned. It will scan until either a null terminator is reached or strlen chars have been read
+ * CORDIC based atan2, returns the angle of the vector (x, y) in the phase format of qSin32() (2^32 = 2pi, negative angles wrap around to the top)
  * 
- * ignoreUnit will make the function not return in an error state if the string contains a unit at the end (like for example "1sec")
+ * usage: phase = qAtan2(beta, alpha), then qSin32(phase) * magnitude = beta. atan2(0, 0) is 0
  * 
- *      NOTE: if the returned value would contain an integer overflow due to an excessively large input number a 0 is returned instead
- *      NOTE: any numbers after the last digit in the fixed point return will be ignored
+ *      integer only and always QCORDIC_ITERATIONS iterations, so the time it takes doesn't depend on the input. The error is below 2e-7 rad (about 150 phase LSBs)
  */
+uint32_t qAtan2(int32_t y, int32_t x){
+    uint32_t angle;
+    qCordicVector(x, y, &angle, NULL);
+    return angle;
+}
 
-static int32_t ctoi(char c){
-    if(!isAsciiNumber(c)) return 0;
-    return c - '0';  //if we are sure that the char is a number, then we can convert it by subtracting the offset of ascii '0' from it
-}
-
-static int32_t getExponent(char c){
-    if(c == 'f')    return -15;
-    if(c == 'p')    return -12;
-    if(c == 'n')    return -9;
-    if(c == 'u' || c == 230) return -6;    //ascii 230 is the greek micro
-    if(c == 'm')    return -3;
-    if(c == 'c')    return -2;
-    if(c == 'd')    return -1;
-    if(c == '.')    return 0;
-    if(c == 'h')    return 2;
-    if(c == 'k')    return 3;
-    if(c == 'M')    return 6;
-    if(c == 'G')    return 9;
-    if(c == 'T')    return 12;
-    if(c == 'P')    return 15;
-    
-    if(isAsciiNumber(c)) return 0xffffffff;
-    return 0x7fffffff;
-}
-
-//precalculated exponents that are reasonable for a int32_t number
-static int32_t exponentTable[10] = {
-1, //10 ^ 0
-10, //10 ^ 1
-100, //10 ^ 2
-1000, //10 ^ 3
-10000, //10 ^ 4
-100000, //10 ^ 5
-1000000, //10 ^ 6
-10000000, //10 ^ 7
-100000000, //10 ^ 8
-1000000000, //10 ^ 9
-};
+/*
+ * magnitude of the vector (x, y) (sqrt(x^2 + y^2)) with the same CORDIC as qAtan2(). The relative error is below 1e-7, at least 1 LSB
+ */
+uint32_t qMag(int32_t x, int32_t y){
+    uint32_t magnitude;
+    qCordicVector(x, y, NULL, &magnitude);
+    return magnitude;
+}
 
-int32_t atoiFP(char * a, uint32_t strlen, int32_t baseExponent, uint32_t ignoreUnit){
-    int32_t ret = 0;
+/*
+ * integer square root, floor(sqrt(x)). Bitwise, so it always takes 16 iterations
+ * 
+ *      NOTE: the square root of a Qn number is Q(n/2), f.e. qSqrt() of a Q16 value is Q8. Shift it up by 8 bits to get Q16 again (with only 8 bits of precision)
+ */
+uint32_t qSqrt(uint32_t x){
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
     
-    enum {waitStart, waitMultiplier, waitEnd, waitE_Exponent} state = waitStart;
-    
-    int32_t currentNumberPositionExponent = 0;
-    
-    uint32_t isNumberNegative = 0;
-    uint32_t isExponentADot = 0;
-    uint32_t breakBit = 0;
-    
-    char* startOfNumber = NULL;
-    char* startOfNumberExponent = NULL;
-    
-    uint32_t checkForLength = strlen > 0;
-    
-    //iterate through the string
-    while(*a != 0 && !breakBit){
-        if(checkForLength) if(!strlen--) break;
-        //TERM_printDebug(TERM_handle, "\r\n\nscanning letter '%c' (%02x) ", *a, *a);
-        
-        int32_t currentExponent = getExponent(*a);
-        
-        //which state are we in?
-        switch(state){
-            case waitStart:
-                //skip any leading spaces
-                if(*a != ' '){
-                    //found a non space char, is it a number?
-                    if(isAsciiNumber(*a)){
-                        //TERM_printDebug(TERM_handle, "\t found start of number ");
-                        //yes, start of number to convert
-                        startOfNumber = a;
-                        state = waitMultiplier;
-                        
-                    }else if(*a == '.'){
-                        //we got a dot as the first char, skip waiting for a first exponent as we already have one here
-                        startOfNumber = a;
-                        currentNumberPositionExponent = 0;
-                        state = waitEnd;
-                        isExponentADot = 1;
-                        
-                    }else if(*a == '-'){
-                        //no, but the current character is a minus sign, invert the sign of the return number
-                        isNumberNegative = !isNumberNegative;
-                        //TERM_printDebug(TERM_handle, "\tfound sign (number is now %d) ", isNumberNegative ? "negative" : "positive");
-                        
-                    }else if(*a != '+'){    //a number string with a leading plus is also valid, but we don't need to do anything with it
-                        //TERM_printDebug(TERM_handle, "\tfound sign (number is now %d) ", isNumberNegative ? "negative" : "positive");
-                        //no, apparently the string doesn't start with a number => invalid :(
-                        return 0;
-                    }
-                }
-                break;
-            case waitMultiplier:
-                if(currentExponent == 0x7fffffff){
-                    //current character is neither a valid exponent designator or a number. we likely reached the end of the string we need to parse
-                    
-                    //check if by any chance this is an 'e' and there is also at least one more char in this string we can scan
-                    if((*a == 'e' || *a == 'E') && (!checkForLength || strlen) && *(a+1) != 0){
-                        //yes it is
-                        if(*(a+1) == '-' || isAsciiNumber(*(a+1))){
-                            //TERM_printDebug(TERM_handle, "\tfound start of exponent string ");
-                            //and it is also a number, yay. That means we must now scan for the end of the added exponent
-                            startOfNumberExponent = a + 1;
-                            state = waitE_Exponent;
-                        }else{
-                            //TERM_printDebug(TERM_handle, "\tpotential start of exponent string was invalid ");
-                            //break out of the loop and continue on to the conversion
-                            breakBit = 1;
-                            break;
-                        }
-                    }else{
-                        //TERM_printDebug(TERM_handle, "\tend of number ");
-                        //break out of the loop and continue on to the conversion
-                        breakBit = 1;
-                        break;
-                    }
-                    
-                }else if(currentExponent != 0xffffffff){
-                        
-                    //we found an exponent of some description. remember its value as we continue through the string
-                    currentNumberPositionExponent = currentExponent;
-                    state = waitEnd;
-                    
-                    //now check if the exponent is a dot, if so we can accept another real exponent at the end of the string
-                    if(currentExponent == 0) isExponentADot = 1;
-                    
-                    //TERM_printDebug(TERM_handle, "\tfound a first exponent (%d) currNumExp=%d ", currentExponent, currentNumberPositionExponent);
-                }else{
-                    //TERM_printDebug(TERM_handle, "\tthat's just a digit :) ");
-                }
-                break;
-            case waitEnd:
-                if(!isAsciiNumber(*a)){
-                    //we've reached another non number
-                    
-                    //check if the first non number found was a dot and we currently have a valid exponent
-                    if(isExponentADot){
-                        
-                        //yes it was. Now check if we have reached the start of a numerical exponent string
-                        if((*a == 'e' || *a == 'E') && strlen){
-                            //yes it is
-                            if(*(a+1) == '-' || isAsciiNumber(*(a+1))){
-                                //TERM_printDebug(TERM_handle, "\tfound exponent string start ");
-                                //and it is also a number, yay. That means we must now scan for the end of the added exponent
-                                startOfNumberExponent = a + 1;
-                                state = waitE_Exponent;
-                            }else{
-                                //TERM_printDebug(TERM_handle, "\tfound non exponent string start ");
-                                
-                                //break out of the loop and continue on to the conversion
-                                breakBit = 1;
-                                break;
-                            }
-                        }else if(currentExponent != 0x7fffffff){
-                            //TERM_printDebug(TERM_handle, "\tfound exponent after string %d ", currentExponent);
-                            
-                            currentNumberPositionExponent += currentExponent;
-                    
-                            //break out of the loop and continue on to the conversion
-                            breakBit = 1;
-                            break;
-                        }else{
-                            //TERM_printDebug(TERM_handle, "\tfound end of number string without exponent after dot");
-                            
-                            //a dot was the first exponent and we have now reached the first non digit after it, but it isn't a valid exponent (so probably a unit)
-                            //check if we are allowed to ignore this and convert anyway or must return with an error
-                            if(!ignoreUnit) return 0;
-
-                            //otherwise break out of the loop and continue on to the conversion
-                            breakBit = 1;
-                            break;
-                        }
-                    }else{
-                        //TERM_printDebug(TERM_handle, "\tfound end of number string with exponent ");
-                        //no we already got a valid exponent or aren't even scanning one now. We must be at the start of the unit
-                        //check if we are allowed to ignore this and convert anyway or must return with an error
-                        if(!ignoreUnit) return 0;
-                    
-                        //otherwise break out of the loop and continue on to the conversion
-                        breakBit = 1;
-                        break;
-                    }
-                }else{
-                    //we are scanning a number, make sure to decrease the current numbers exponent as we are after the point
-                    currentNumberPositionExponent--;
-                    //TERM_printDebug(TERM_handle, "\tcurrNumExp=%d ", currentNumberPositionExponent);
-                }
-                break;
-                
-            case waitE_Exponent:
-                //we have passed a "e" in the string and must now find the end of the number after it
-                
-                //check if we are still scanning a number or the sign (but sign only if it is the first char in the exponent string)
-                if(!isAsciiNumber(*a) && !((*a == '-' || *a == '+') && a == startOfNumberExponent)){
-                    //TERM_printDebug(TERM_handle, "\tfound end of exponent string ");
-                    //found first non sign and non number char, that means we are now at the end of the exponent number string
-                    
-                    //break the loop and let the conversion routinge handle the exponent string
-                    breakBit = 1;
-                    break;
-                }else{
-                    //TERM_printDebug(TERM_handle, "\tthat's just a digit :) ");
-                }
-                break;
+    //one result bit per iteration, starting with the highest possible one
+    for(uint32_t i = 0; i < 16; i++){
+        if(x >= result + bit){
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        }else{
+            result >>= 1;
         }
-        
-        if(!breakBit) a++;
+        bit >>= 2;
     }
     
-    //are we still waiting for the end on an exponent string?
-    if(state == waitE_Exponent){
-        //yes, we are now at the end of it
-        //TERM_printDebug(TERM_handle, "string ended with end of exponent string ");
-        //found first non sign and non number char, that means we are now at the end of the exponent number string
-
-        //copy that number into a new string for conversion
-        uint32_t i = 0;
-        char exponentBuffer[11];
-        char * exponentStringPosition = startOfNumberExponent;
-        for(; i < 10 && exponentStringPosition != a; i++){
-            exponentBuffer[i] = *(exponentStringPosition++);
-        }
-        //terminate the string
-        exponentBuffer[i] = 0;
-
-        //did we actually get an entire string or was the buffer too small?
-        if(exponentStringPosition == a){
-            //yes that worked, now convert the number to an int with the normal atoi function
-            int32_t newExponent = atoi(exponentBuffer);
-            currentNumberPositionExponent += newExponent;
-
-            //TERM_printDebug(TERM_handle, "\t\tcopied string: \"%s\"=", exponentBuffer, newExponent);
+    return result;
+}
 
-            //now roll back the current char pointer to the 'e' we scanned before entering this state
-            //this is to allow for the conversion to take place as if no numerical exponent existed after the number
-            a = startOfNumberExponent-1;
-        }else{
-            //TERM_printDebug(TERM_handle, "\t\texponent buffer was too small :(");
-            //no didn't work unfortunately, that means the number read was invalid and we must return 0
-            return 0;
-        }
+//CORDIC in vectoring mode: rotates (x, y) onto the x axis and sums up the angles it took. angle and magnitude can be NULL
+static void qCordicVector(int32_t x, int32_t y, uint32_t * angle, uint32_t * magnitude){
+    if(x == 0 && y == 0){
+        if(angle != NULL) *angle = 0;
+        if(magnitude != NULL) *magnitude = 0;
+        return;
     }
     
-    //check if we successfully exited the loop
-    if(startOfNumber == NULL){
-        //no :( no number was found
-        return 0;
+    //the left half plane is rotated by 180deg first, CORDIC only converges within +-99deg
+    int64_t currentX = x;
+    int64_t currentY = y;
+    uint32_t currentAngle = 0;
+    if(x < 0){
+        currentX = -currentX;
+        currentY = -currentY;
+        currentAngle = 1UL << 31;
     }
     
-    //shift the fixed point exponent by the base exponent
-    currentNumberPositionExponent += baseExponent;
-                        
-    //TERM_printDebug(TERM_handle, "Now converting the number with the current exponent of %d (from base %d)", currentNumberPositionExponent, baseExponent);
-    
-    //start of number found, we are now one byte after the end of the number string, step backwards through the string and do the converstion
-    while(*--a != 0 && a >= startOfNumber){
-        //TERM_printDebug(TERM_handle, "\r\n\nscanning letter '%c' (%02x) ", *a, *a);
-        
-        //is the character we are at right now a number?
-        if(isAsciiNumber(*a)){
-            //yes, would it actually be put into the return value? it wouldn't if the exponent was too low or too big
-            if(currentNumberPositionExponent >= 0){
-                if(currentNumberPositionExponent < 10){
-                    //yes, convert it
-                    int32_t currentNumber = ctoi(*a);
-                    
-                    //TERM_printDebug(TERM_handle, "\tconverted digit to int = %d", currentNumber);
-                    
-                    //and finally do a check for a potential overflow if a digit larger than 2 gets multiplied with the largest exponent
-                    if(currentNumberPositionExponent == 9 && currentNumber > 2){
-                        //TERM_printDebug(TERM_handle, "\t=> would overflow :( ");
-                        //yes overflow would occur :(
-                        return 0;
-                    }
-                    
-                    //no overflow would occur, scale the number by the current exponent
-                    currentNumber *= exponentTable[currentNumberPositionExponent];
-                    
-                    //TERM_printDebug(TERM_handle, "\tscaled with exponent %d (10^%d) = %d ", exponentTable[currentNumberPositionExponent], currentNumberPositionExponent, currentNumber);
-                    
-                    ret += currentNumber;
-                    
-                    //TERM_printDebug(TERM_handle, "\tret is now %d ", ret);
-                }else{
-                    //TERM_printDebug(TERM_handle, "\tignoring number due to exponent > 10 (%d)", currentNumberPositionExponent);
-                    //a number with too big of an exponent would be converted, which would cause an overflow. return 0 so the user notices something is wrong
-                    return 0;
-                }
-            }else{
-                //TERM_printDebug(TERM_handle, "\tignoring number due to exponent < 0 (%d)", currentNumberPositionExponent);
-            }
-                    
-            //increase position exponent by one for the digit to the left of us
-            currentNumberPositionExponent++;
+    //scale the vector up so small ones get the same precision as large ones. That is at most 31 bits, the gain of 1.65 still fits the int64 easily
+    uint64_t largest = (uint64_t) currentX | (uint64_t) ((currentY < 0) ? -currentY : currentY);
+    uint32_t shift = 0;
+    for(uint32_t step = 16; step > 0; step >>= 1){
+        if((largest << (shift + step)) < (1ULL << 31)) shift += step;
+    }
+    currentX *= 1LL << shift;
+    currentY *= 1LL << shift;
+    
+    for(uint32_t i = 0; i < QCORDIC_ITERATIONS; i++){
+        int64_t lastX = currentX;
+        
+        //rotate towards the x axis, by atan(2^-i) either way
+        if(currentY > 0){
+            currentX += currentY >> i;
+            currentY -= lastX >> i;
+            currentAngle += cordicAngleTable[i];
         }else{
-            //TERM_printDebug(TERM_handle, "\tnot a number, skipping character ");
-            //current char is not a number, this should only occur once [perhaps TODO check if that has worked] (as we scan over the point or the exponent). Just skip it
+            currentX -= currentY >> i;
+            currentY += lastX >> i;
+            currentAngle -= cordicAngleTable[i];
         }
     }
-                    
-    //TERM_printDebug(TERM_handle, "conversion done! result without sign = %d ", ret);
     
-    //and finally return the number taking the sign bit into account
-    return isNumberNegative ? -ret : ret;
+    if(angle != NULL) *angle = currentAngle;
+    
+    //x is now the magnitude times the CORDIC gain (1.6468). Remove that and the scaling from the start
+    if(magnitude != NULL){
+        uint64_t scaled = ((uint64_t) currentX * QCORDIC_INVERSE_GAIN + (1ULL << 31)) >> 32;
+        *magnitude = (uint32_t) ((scaled + ((1ULL << shift) >> 1)) >> shift);
+    }
 }
 
+#ifdef UTIL_BENCHMARK
+//sink for the benchmark results, so the compiler can't remove the calls
+static volatile int32_t benchSink;
 
+//runs of the current benchmark that failed (f.e. because an allocation returned NULL), the statements count them themselves
+static uint32_t benchFailures;
 
+//runs STATEMENT COUNT times and prints the time per run (minus the cost of the loop itself), the bytes every run allocated and how many runs failed
+#define UTIL_BENCH(PRINT, NAME, COUNT, STATEMENT) do{ \
+    benchFailures = 0; \
+    size_t startBytes = utilAllocatedBytes; \
+    uint32_t startCycles = UTIL_getCycles(); \
+    for(uint32_t run = 0; run < (COUNT); run++){ STATEMENT; } \
+    uint32_t cycles = UTIL_getCycles() - startCycles; \
+    UTIL_printBenchResult(PRINT, NAME, cycles, COUNT, utilAllocatedBytes - startBytes, benchFailures); \
+}while(0)
 
+//cost of one empty benchmark loop run in tenths of a cycle, measured once by UTIL_benchmark()
+static uint32_t benchOverhead = 0;
 
+static void UTIL_printBenchResult(PWL_printFunction_t print, const char * name, uint32_t cycles, uint32_t count, size_t bytes, uint32_t failures){
+    //tenths of a cycle per call, the fast paths only take a few
+    uint64_t perCall = ((uint64_t) cycles * 10 + count / 2) / count;
+    perCall = (perCall > benchOverhead) ? perCall - benchOverhead : 0;
+    
+#ifdef UTIL_HAS_DWT
+    const char * unit = "cycles";
+#else
+    const char * unit = "ns";
+#endif
+    print("%-36s %8lu.%lu %s/call %6lu bytes/call", name, (unsigned long) (perCall / 10), (unsigned long) (perCall % 10), unit, (unsigned long) (bytes / count));
+    
+    //a failed run usually returns early, so its time means nothing. Make that obvious instead of printing a nice low number
+    if(failures != 0) print("   %lu of %lu runs FAILED", (unsigned long) failures, (unsigned long) count);
+    print("\r\n");
+}
 
-
-
+//the same interpolation as PWL_getY() but the segment is found by walking through the rows one by one, as a baseline for the searches
+static int32_t UTIL_benchLinearScan(int32_t x, const Pwl_t * pwl){
+    uint32_t segment = 0;
+    while(segment + 2 < pwl->listSizeRows && x >= PWL_getPointX(pwl, segment + 1)) segment++;
+    return PWL_interpolate(x, pwl, segment);
+}
 
 /*
- * LUT based fast sine function
+ * benchmark of the hot paths. Prints the time every function takes per call and how much memory it allocated
+ * 
+ * usage: build util.c with UTIL_BENCHMARK defined and call UTIL_benchmark(printf) (or any other printf compatible function). 
+ *      On a host that's bench/host.c, on the target call it from a task or a TTerm command. Repeat it with CONFIG_benchmark() for the config parser
+ * 
+ *      A run that fails (f.e. the allocator is out of memory) is counted and printed next to the result, the default arena is too small for the larger 
+ *      tables and configs. bench/host.c installs malloc() and free() with UTIL_setAllocator() for that reason
  * 
- * parameter is a variable between 0-512 with 512 = 2pi. Return value is 0-500000
- *     
+ *      NOTE: the numbers only mean something with the compiler flags of the real firmware, interrupts and other tasks will show up in them too
  */
+void UTIL_benchmark(PWL_printFunction_t print){
+    UTIL_initCycleCounter();
+    
+    //inputs that are cycled through so the branch predictor and the cursor can't just remember one of them. 64 of each, so run & 63 picks one
+    int32_t resistances[64];
+    int32_t temperatures[64];
+    uint32_t phases[64];
+    for(uint32_t i = 0; i < 64; i++){
+        //spread over 1k to 30k in a scrambled order
+        uint32_t scrambled = (i * 37) & 63;
+        resistances[i] = 1000 + scrambled * 450;
+        temperatures[i] = -20000 + (int32_t) scrambled * 2000;
+        phases[i] = scrambled * 0x04000000UL + i * 12345;
+    }
+    static const char * const numbers[8] = {"1", "3.3", "-12.5m", "4.7k", "0.000123", "123456789", "2.2u", "  -0.5 V"};
+    
+    benchOverhead = 0;
+    {
+        //the loop itself, subtracted from all other results
+        uint32_t startCycles = UTIL_getCycles();
+        for(uint32_t run = 0; run < 10000; run++){ benchSink = resistances[run & 63]; }
+        uint32_t cycles = UTIL_getCycles() - startCycles;
+        benchOverhead = (uint32_t) (((uint64_t) cycles * 10 + 5000) / 10000);
+    }
+    print("loop overhead %lu.%lu, subtracted from everything below\r\n", (unsigned long) (benchOverhead / 10), (unsigned long) (benchOverhead % 10));
+    
+    NTC_Coefficients_t ntc = {.R0 = 10000, .T0 = 298.15f, .Beta = 3950, .model = NTC_MODEL_BETA};
+    NTC_FixedCoefficients_t ntcFixed;
+    NTC_initFixed(&ntcFixed, &ntc);
+    
+    //lookups by table size, points with the binary search, points with a cursor and uniform without any search
+    static const uint32_t sizes[] = {8, 32, 128};
+    char name[40];
+    for(uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+        Pwl_t * points = NTC_generatePWL(&ntc, -5000, 80000, sizes[i], NTC_MILLI_DEG_CELSIUS);
+        Pwl_t * uniform = NTC_generateUniformPWL(&ntc, -5000, 80000, sizes[i], NTC_MILLI_DEG_CELSIUS);
+        if(points == NULL || uniform == NULL){
+            print("not enough memory for a %lu point table\r\n", (unsigned long) sizes[i]);
+            if(points != NULL) PWL_delete(points, 0);
+            if(uniform != NULL) PWL_delete(uniform, 0);
+            break;
+        }
+        
+        PwlCursor_t cursor = {0};
+        snprintf(name, sizeof(name), "linear scan baseline, %lu rows", (unsigned long) sizes[i]);
+        UTIL_BENCH(print, name, 10000, benchSink = UTIL_benchLinearScan(resistances[run & 63], points));
+        snprintf(name, sizeof(name), "PWL_getY points, %lu rows", (unsigned long) sizes[i]);
+        UTIL_BENCH(print, name, 10000, benchSink = PWL_getY(resistances[run & 63], points));
+        snprintf(name, sizeof(name), "PWL_getYCursor sweep, %lu rows", (unsigned long) sizes[i]);
+        UTIL_BENCH(print, name, 10000, benchSink = PWL_getYCursor(1000 + (int32_t) (run & 1023) * 28, points, &cursor));
+        snprintf(name, sizeof(name), "PWL_getY uniform, %lu rows", (unsigned long) uniform->listSizeRows);
+        UTIL_BENCH(print, name, 10000, benchSink = PWL_getY(resistances[run & 63], uniform));
+        snprintf(name, sizeof(name), "PWL_getX points, %lu rows", (unsigned long) sizes[i]);
+        UTIL_BENCH(print, name, 10000, benchSink = PWL_getX(temperatures[run & 63], points));
+        
+        PWL_delete(points, 0);
+        PWL_delete(uniform, 0);
+    }
+    
+    //table generation
+    UTIL_BENCH(print, "NTC_generatePWL, 32 points", 100, {
+        Pwl_t * pwl = NTC_generatePWL(&ntc, -5000, 80000, 32, NTC_MILLI_DEG_CELSIUS);
+        if(pwl != NULL) PWL_delete(pwl, 0); else benchFailures++;
+    });
+    
+    //direct conversions
+    UTIL_BENCH(print, "NTC_getTemperatureAtResistance", 1000, benchSink = NTC_getTemperatureAtResistance(&ntc, (float) resistances[run & 63], NTC_MILLI_DEG_CELSIUS));
+    UTIL_BENCH(print, "NTC_getResistanceAtTemperature", 1000, benchSink = (int32_t) NTC_getResistanceAtTemperature(&ntc, temperatures[run & 63], NTC_MILLI_DEG_CELSIUS));
+    UTIL_BENCH(print, "NTC_getTemperatureAtResistanceFixed", 1000, benchSink = NTC_getTemperatureAtResistanceFixed(&ntcFixed, (uint32_t) resistances[run & 63], NTC_MILLI_DEG_CELSIUS));
+    UTIL_BENCH(print, "NTC_getResistanceAtTemperatureFixed", 1000, benchSink = (int32_t) NTC_getResistanceAtTemperatureFixed(&ntcFixed, temperatures[run & 63], NTC_MILLI_DEG_CELSIUS));
+    
+    //number parsing, one string after the other
+    uint32_t lengths[8];
+    for(uint32_t i = 0; i < 8; i++) lengths[i] = strlen(numbers[i]);
+    UTIL_BENCH(print, "atoiFP, mixed strings", 10000, benchSink = atoiFP(numbers[run & 7], lengths[run & 7], -3, 1));
+    for(uint32_t i = 0; i < 8; i++){
+        snprintf(name, sizeof(name), "atoiFP \"%s\"", numbers[i]);
+        UTIL_BENCH(print, name, 2000, benchSink = atoiFP(numbers[i], lengths[i], -3, 1));
+    }
+    
+    //sine
+    UTIL_BENCH(print, "qSin", 10000, benchSink = qSin((int32_t) (phases[run & 63] >> 23)));
+    UTIL_BENCH(print, "qSin32", 10000, benchSink = qSin32(phases[run & 63]));
+}
 
-
-//256 value sin lookup table x := [0, pi)
-//TODO reduce this by half, symmetry's a bitch ;)
-static const int32_t sineTable[] = {0, 6135, 12270, 18403, 24533, 30660, 36782, 42898, 49008, 55111, 61205, 67290, 73365, 79429, 85480, 91519, 97545, 103555, 109550, 115529, 121490, 127432, 133356, 139259, 145142, 151002, 156840, 162655, 168444, 174209, 179947, 185658, 191341, 196996, 202620, 208214, 213777, 219308, 224805, 230269, 235698, 241091, 246449, 251769, 257051, 262294, 267498, 272662, 277785, 282865, 287904, 292898, 297849, 302755, 307615, 312429, 317196, 321915, 326586, 331207, 335779, 340300, 344770, 349188, 353553, 357865, 362123, 366327, 370475, 374568, 378604, 382583, 386505, 390368, 394173, 397918, 401603, 405228, 408792, 412294, 415734, 419112, 422426, 425677, 428864, 431986, 435043, 438035, 440960, 443819, 446612, 449337, 451994, 454583, 457104, 459556, 461939, 464253, 466496, 468669, 470772, 472803, 474764, 476653, 478470, 480215, 481888, 483488, 485015, 486469, 487851, 489158, 490392, 491552, 492638, 493650, 494588, 495451, 496239, 496953, 497592, 498156, 498645, 499059, 499397, 499661, 499849, 499962, 500000, 499962, 499849, 499661, 499397, 499059, 498645, 498156, 497592, 496953, 496239, 495451, 494588, 493650, 492638, 491552, 490392, 489158, 487851, 486469, 485015, 483488, 481888, 480215, 478470, 476653, 474764, 472803, 470772, 468669, 466496, 464253, 461939, 459556, 457104, 454583, 451994, 449337, 446612, 443819, 440960, 438035, 435043, 431986, 428864, 425677, 422426, 419112, 415734, 412294, 408792, 405228, 401603, 397918, 394173, 390368, 386505, 382583, 378604, 374568, 370475, 366327, 362123, 357865, 353553, 349188, 344770, 340300, 335779, 331207, 326586, 321915, 317196, 312429, 307615, 302755, 297849, 292898, 287904, 282865, 277785, 272662, 267498, 262294, 257051, 251769, 246449, 241091, 235698, 230269, 224805, 219308, 213777, 208214, 202620, 196996, 191341, 185658, 179947, 174209, 168444, 162655, 156840, 151002, 145142, 139259, 133356, 127432, 121490, 115529, 109550, 103555, 97545, 91519, 85480, 79429, 73365, 67290, 61205, 55111, 49008, 42898, 36782, 30660, 24533, 18403, 12270, 6135};
-
-int32_t qSin(int32_t x){
-    int32_t xt = abs(x) % 0xff;
+#if __has_include("ff.h")
+/*
+ * benchmark of CONFIG_getKey() and CONFIG_load() with generated config files of 16 to 1024 lines
+ * 
+ * usage: scratch must be a file opened for reading and writing, it is overwritten with the test configs. Prints in the same format as UTIL_benchmark()
+ * 
+ *      NOTE: SD card access times are part of the result, on a host it's the OS file cache
+ */
+void CONFIG_benchmark(FIL * scratch, PWL_printFunction_t print){
+    UTIL_initCycleCounter();
     
-    if(xt == 0) return 0;
-    return (x > 0) ? sineTable[xt] : -sineTable[xt];
-}
\ No newline at end of file
+    char line[48];
+    char name[48];
+    for(uint32_t lineCount = 16; lineCount <= 1024; lineCount *= 4){
+        //"keyN = N.5k //lineN". The last key is the worst case for CONFIG_getKey()
+        f_lseek(scratch, 0);
+        f_truncate(scratch);
+        for(uint32_t i = 0; i < lineCount; i++){
+            UINT written = 0;
+            int length = snprintf(line, sizeof(line), "key%lu = %lu.5k //line %lu\r\n", (unsigned long) i, (unsigned long) i, (unsigned long) i);
+            if(f_write(scratch, line, (UINT) length, &written) != FR_OK || written != (UINT) length){
+                print("writing the test config failed\r\n");
+                return;
+            }
+        }
+        f_sync(scratch);
+        
+        char lastKey[16];
+        snprintf(lastKey, sizeof(lastKey), "key%lu", (unsigned long) (lineCount - 1));
+        
+        snprintf(name, sizeof(name), "CONFIG_getKey last of %lu", (unsigned long) lineCount);
+        UTIL_BENCH(print, name, 8, {
+            char * value = CONFIG_getKey(scratch, lastKey);
+            if(value != NULL) UTIL_FREE(value); else benchFailures++;
+        });
+        
+        snprintf(name, sizeof(name), "CONFIG_load %lu lines", (unsigned long) lineCount);
+        Config_t * cfg = NULL;
+        UTIL_BENCH(print, name, 1, if((cfg = CONFIG_load(scratch)) == NULL) benchFailures++);
+        if(cfg == NULL){
+            print("not enough memory for the index of %lu lines\r\n", (unsigned long) lineCount);
+            return;
+        }
+        
+        snprintf(name, sizeof(name), "CONFIG_getInt, %lu entries", (unsigned long) lineCount);
+        UTIL_BENCH(print, name, 1000, benchSink = CONFIG_getInt(cfg, lastKey, 0, 0));
+        CONFIG_free(cfg);
+    }
+}
+#endif
+#endif